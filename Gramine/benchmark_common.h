@@ -0,0 +1,288 @@
+// benchmark_common.h - Parameters and latency output shared by the OpenFHE benchmarks
+#ifndef BENCHMARK_COMMON_H
+#define BENCHMARK_COMMON_H
+
+#include "openfhe.h"
+#include "cryptocontext-ser.h"
+#include "key/key-ser.h"
+#include "scheme/ckksrns/ckksrns-ser.h"
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lbcrypto;
+
+// Usage: <benchmark> [iterations] [ringDim] [scaleBits] [depth] [--slots=S] [--threads=T] [--workers=W]
+//                    [--samples=path] [--keys=dir] [--startup=R]
+// The positional order follows ckks_app. Without a ring dimension OpenFHE
+// picks one for 128-bit security, as before; with one, security checks are
+// off so the ring matches the SDK enclave's exactly.
+struct BenchmarkParams {
+    int iterations;
+    uint32_t ringDim;       // 0: chosen by OpenFHE
+    uint32_t scaleBits;
+    uint32_t depth;
+    uint32_t slots;         // batch size
+    uint32_t messageLength;
+    int threads;            // OpenMP threads per operation, 0 keeps the default
+    int workers;            // concurrent callers (throughput mode), 0 runs one sequential loop
+    std::string samples;    // per-iteration latencies in ms, one per line
+    std::string keys;       // serialized context and key pair, reused across launches
+    int startup;            // start-up timing rounds, 0 runs the benchmark
+    bool evaluation;        // eval_benchmark: manual rescaling, SHE features and its own key files
+};
+
+static std::string get_option(int argc, char* argv[], const std::string& name, const std::string& fallback) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0) return arg.substr(prefix.size());
+    }
+    return fallback;
+}
+
+static BenchmarkParams parse_params(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).compare(0, 2, "--") != 0) args.push_back(argv[i]);
+    }
+
+    BenchmarkParams params;
+    params.iterations = (args.size() > 0) ? std::stoi(args[0]) : 10000; // Default to 10000 if not provided
+    params.ringDim = (args.size() > 1) ? (uint32_t)std::stoul(args[1]) : 0;
+    params.scaleBits = (args.size() > 2) ? (uint32_t)std::stoul(args[2]) : 30;
+    params.depth = (args.size() > 3) ? (uint32_t)std::stoul(args[3]) : 1;
+    // Without a ring or slot count, the original 4096 values in a batch of 8192
+    std::string slots = get_option(argc, argv, "slots", "");
+    if (slots.empty()) {
+        params.slots = params.ringDim ? params.ringDim / 2 : 8192;
+        params.messageLength = params.ringDim ? params.slots : 4096;
+    } else {
+        params.slots = (uint32_t)std::stoul(slots);
+        params.messageLength = params.slots;
+    }
+    params.threads = std::stoi(get_option(argc, argv, "threads", "0"));
+    params.workers = std::stoi(get_option(argc, argv, "workers", "0"));
+    params.samples = get_option(argc, argv, "samples", "");
+    params.keys = get_option(argc, argv, "keys", "");
+    params.startup = std::stoi(get_option(argc, argv, "startup", "0"));
+    params.evaluation = false;
+    return params;
+}
+
+static CryptoContext<DCRTPoly> make_context(const BenchmarkParams& params) {
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(params.depth);
+    parameters.SetBatchSize(params.slots);
+    parameters.SetScalingModSize(params.scaleBits);
+    if (params.ringDim) {
+        parameters.SetSecurityLevel(HEStd_NotSet);
+        parameters.SetRingDim(params.ringDim);
+    }
+    // Rescaling is explicit, as in the SDK enclave, so it can be timed alone
+    if (params.evaluation) parameters.SetScalingTechnique(FIXEDMANUAL);
+
+    CryptoContext<DCRTPoly> cryptoContext = GenCryptoContext(parameters);
+    cryptoContext->Enable(PKE);
+    if (params.evaluation) {
+        cryptoContext->Enable(KEYSWITCH);
+        cryptoContext->Enable(LEVELEDSHE);
+        cryptoContext->Enable(ADVANCEDSHE);
+    }
+    return cryptoContext;
+}
+
+// One file per object under --keys, named by the parameters that shape the
+// context; ring 0 stands for OpenFHE's choice
+static std::string key_file(const BenchmarkParams& params, const std::string& object) {
+    return params.keys + (params.evaluation ? "/ckks_eval_" : "/ckks_") + std::to_string(params.ringDim) + "_" +
+           std::to_string(params.scaleBits) + "_" + std::to_string(params.depth) + "_" +
+           std::to_string(params.slots) + "_" + object + ".bin";
+}
+
+// Evaluation keys saved next to an earlier key pair belong to its secret
+// key, so saving a new pair removes them
+static bool save_keys(const BenchmarkParams& params, const CryptoContext<DCRTPoly>& cryptoContext,
+                      const KeyPair<DCRTPoly>& keyPair) {
+    if (params.evaluation) {
+        std::remove(key_file(params, "mult").c_str());
+        std::remove(key_file(params, "rotate").c_str());
+    }
+    return Serial::SerializeToFile(key_file(params, "context"), cryptoContext, SerType::BINARY) &&
+           Serial::SerializeToFile(key_file(params, "public"), keyPair.publicKey, SerType::BINARY) &&
+           Serial::SerializeToFile(key_file(params, "secret"), keyPair.secretKey, SerType::BINARY);
+}
+
+// Keys attach to the context they were made with, so the context is
+// deserialized first. OpenFHE caches contexts by parameters; dropping the
+// cache makes every load a real one.
+static bool load_context(const BenchmarkParams& params, CryptoContext<DCRTPoly>& cryptoContext) {
+    CryptoContextFactory<DCRTPoly>::ReleaseAllContexts();
+    return Serial::DeserializeFromFile(key_file(params, "context"), cryptoContext, SerType::BINARY);
+}
+
+static bool load_keys(const BenchmarkParams& params, KeyPair<DCRTPoly>& keyPair) {
+    return Serial::DeserializeFromFile(key_file(params, "public"), keyPair.publicKey, SerType::BINARY) &&
+           Serial::DeserializeFromFile(key_file(params, "secret"), keyPair.secretKey, SerType::BINARY);
+}
+
+// Context and key pair for the benchmark: loaded from --keys when an
+// earlier launch saved them there, otherwise generated, and saved when
+// --keys is given. *loaded tells which. Returns an empty context on failure.
+static CryptoContext<DCRTPoly> setup_context(const BenchmarkParams& params, KeyPair<DCRTPoly>& keyPair,
+                                             bool* loaded = NULL) {
+    if (params.threads > 0) omp_set_num_threads(params.threads);
+    if (loaded != NULL) *loaded = false;
+
+    CryptoContext<DCRTPoly> cryptoContext;
+    if (!params.keys.empty() && load_context(params, cryptoContext)) {
+        if (load_keys(params, keyPair)) {
+            std::cout << "Loaded context and keys from " << params.keys << std::endl;
+            if (loaded != NULL) *loaded = true;
+            return cryptoContext;
+        }
+        std::cerr << "Cannot load the keys in " << params.keys << std::endl;
+        return CryptoContext<DCRTPoly>();
+    }
+
+    cryptoContext = make_context(params);
+    std::cout << "Generating keys..." << std::endl;
+    keyPair = cryptoContext->KeyGen();
+    if (!params.keys.empty() && !save_keys(params, cryptoContext, keyPair)) {
+        std::cerr << "Cannot save the context and keys to " << params.keys << std::endl;
+        return CryptoContext<DCRTPoly>();
+    }
+    return cryptoContext;
+}
+
+static double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool write_samples(const std::string& path, const std::vector<double>& samples) {
+    if (path.empty()) return true;
+    std::ofstream out(path.c_str());
+    for (size_t i = 0; i < samples.size(); i++) out << samples[i] << "\n";
+    return (bool)out;
+}
+
+// Nearest-rank percentile of ascending samples
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+// Splits the iterations across `workers` threads that share the context and
+// keys; op(w) performs one operation on worker w's own buffers. The OpenMP
+// team size is per thread, so every worker sets it again. Appends each
+// operation's latency to `latencies` and returns aggregate operations per
+// second.
+template <typename Op>
+static double run_workers(const BenchmarkParams& params, int workers, Op op, std::vector<double>& latencies) {
+    std::vector<std::vector<double> > per_worker(workers);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int w = 0; w < workers; w++) {
+        int share = params.iterations / workers + ((w < params.iterations % workers) ? 1 : 0);
+        threads.push_back(std::thread([&, w, share]() {
+            if (params.threads > 0) omp_set_num_threads(params.threads);
+            for (int i = 0; i < share; i++) {
+                auto sent = std::chrono::high_resolution_clock::now();
+                op(w);
+                per_worker[w].push_back(elapsed_ms(sent));
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    double seconds = elapsed_ms(start) / 1000.0;
+
+    for (int w = 0; w < workers; w++) {
+        latencies.insert(latencies.end(), per_worker[w].begin(), per_worker[w].end());
+    }
+    return params.iterations / seconds;
+}
+
+// Throughput mode: 1, 2, 4, ... --workers concurrent workers, one CSV row
+// per count. `samples` receives the latencies of the largest count.
+template <typename Op>
+static void run_scaling(const BenchmarkParams& params, Op op, std::vector<double>& samples) {
+    const int ompThreads = (params.threads > 0) ? params.threads : omp_get_max_threads();
+    std::cout << "workers,omp_threads,ops_per_sec,mean_ms,p50_ms,p99_ms" << std::endl;
+    for (int w = 1; w <= params.workers;
+         w = (w * 2 > params.workers && w < params.workers) ? params.workers : w * 2) {
+        std::vector<double> latencies;
+        double rate = run_workers(params, w, op, latencies);
+
+        samples = latencies;
+        std::sort(latencies.begin(), latencies.end());
+        double mean = 0.0;
+        for (size_t i = 0; i < latencies.size(); i++) mean += latencies[i];
+        mean /= latencies.size();
+        std::cout << w << "," << ompThreads << "," << rate << "," << mean << "," << percentile(latencies, 0.50)
+                  << "," << percentile(latencies, 0.99) << std::endl;
+    }
+}
+
+// Start-up mode (--startup=R, needs --keys): R rounds of a cold start, i.e.
+// context generation and keygen, against loading the saved context and
+// keys, each up to the first ciphertext. Saving is not timed.
+static int run_startup(const BenchmarkParams& params) {
+    if (params.keys.empty()) {
+        std::cerr << "--startup needs --keys=dir" << std::endl;
+        return 1;
+    }
+    if (params.threads > 0) omp_set_num_threads(params.threads);
+
+    std::vector<double> message(params.messageLength);
+    for (uint32_t i = 0; i < params.messageLength; i++) message[i] = i * 1.1;
+
+    std::cout << "start,round,context_ms,keys_ms,first_ciphertext_ms,total_ms" << std::endl;
+    for (int round = 0; round < params.startup; round++) {
+        for (int loading = 0; loading < 2; loading++) {
+            CryptoContextFactory<DCRTPoly>::ReleaseAllContexts();
+            CryptoContext<DCRTPoly> cryptoContext;
+            KeyPair<DCRTPoly> keyPair;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            bool ok = true;
+            if (loading) {
+                ok = load_context(params, cryptoContext);
+            } else {
+                cryptoContext = make_context(params);
+            }
+            double contextMs = elapsed_ms(start);
+            if (loading) {
+                ok = ok && load_keys(params, keyPair);
+            } else {
+                keyPair = cryptoContext->KeyGen();
+            }
+            double keysMs = elapsed_ms(start) - contextMs;
+            if (!ok) {
+                std::cerr << "Cannot load the context and keys from " << params.keys << std::endl;
+                return 1;
+            }
+            Plaintext plaintext = cryptoContext->MakeCKKSPackedPlaintext(message);
+            auto ciphertext = cryptoContext->Encrypt(keyPair.publicKey, plaintext);
+            double totalMs = elapsed_ms(start);
+
+            if (!loading && !save_keys(params, cryptoContext, keyPair)) {
+                std::cerr << "Cannot save the context and keys to " << params.keys << std::endl;
+                return 1;
+            }
+            std::cout << (loading ? "load" : "keygen") << "," << round << "," << contextMs << "," << keysMs << ","
+                      << totalMs - contextMs - keysMs << "," << totalMs << std::endl;
+        }
+    }
+    return 0;
+}
+
+#endif // BENCHMARK_COMMON_H
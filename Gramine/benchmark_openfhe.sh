@@ -1,20 +1,37 @@
 #!/bin/bash
 
 # Combined OpenFHE with Gramine Benchmark Script
-# Usage: ./benchmark_openfhe.sh [iterations]
+# Usage: ./benchmark_openfhe.sh [iterations] [workers]
+# With workers above 1, also measures throughput for 1, 2, 4, ... workers
+# sharing one context, natively and under Gramine, one OpenMP thread each.
+# Every launch reuses the context and keys serialized in keys/ (an encrypted
+# mount under Gramine) or, for native runs, in keys-native/; neither loader
+# can read the other's files. The start-up section compares keygen with
+# loading.
+# The evaluation section sweeps EvalAdd, EvalMult, Rescale, EvalRotate and an
+# inner product over EVAL_RINGS x EVAL_DEPTHS, natively and in the enclave.
 
 ITERATIONS=${1:-10000}
+WORKERS=${2:-1}
 WARMUP_ITERATIONS=5
+KEYS="--keys=keys"
+NATIVE_KEYS="--keys=keys-native"
+EVAL_ITERATIONS=${EVAL_ITERATIONS:-100}
+EVAL_RINGS=${EVAL_RINGS:-"8192 16384 32768"}
+EVAL_DEPTHS=${EVAL_DEPTHS:-"1 3 6"}
+FAILURES=0
 
 # Colors for output
 GREEN='\033[0;32m'
 BLUE='\033[0;34m'
 YELLOW='\033[1;33m'
+RED='\033[0;31m'
 NC='\033[0m' # No Color
 
 echo -e "${YELLOW}=== OpenFHE with Gramine Comprehensive Benchmark ===${NC}"
 echo "Iterations: $ITERATIONS"
 echo "Warm-up Iterations: $WARMUP_ITERATIONS"
+echo "Workers: $WORKERS"
 echo "=============================================="
 
 # Check if SGX is enabled and manifest files exist
@@ -23,6 +40,17 @@ if [ -f "./encrypt_benchmark.manifest.sgx" ] && [ -f "./decrypt_benchmark.manife
     SGX_ENABLED=1
 fi
 
+# OpenFHE does not create the key directories itself
+mkdir -p keys keys-native
+
+# The grep after a benchmark would otherwise hide its exit status
+report_failure() {
+    if [ "$2" -ne 0 ]; then
+        echo -e "${RED}$1 failed with status $2${NC}"
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
 # Function to run benchmark for a specific mode
 run_benchmark() {
     local mode=$1
@@ -39,26 +67,99 @@ run_benchmark() {
     for ((i=1; i<=$WARMUP_ITERATIONS; i++))
     do
         if [ "$SGX_ENABLED" -eq 1 ]; then
-            gramine-sgx $binary 1 > /dev/null 2>&1
+            gramine-sgx $binary 1 $KEYS > /dev/null 2>&1
         else
-            $binary 1 > /dev/null 2>&1
+            $binary 1 $NATIVE_KEYS > /dev/null 2>&1
         fi
     done
 
     # Actual benchmark
     echo -e "${BLUE}Running $mode benchmark...${NC}"
     if [ "$SGX_ENABLED" -eq 1 ]; then
-        gramine-sgx $binary $ITERATIONS
+        gramine-sgx $binary $ITERATIONS $KEYS
     else
-        $binary $ITERATIONS
+        $binary $ITERATIONS $NATIVE_KEYS
+    fi
+    echo "--------------------------------------------"
+}
+
+# Thread scaling: the same sweep outside and inside the enclave
+run_scaling() {
+    local mode=$1
+    local binary="./${mode}_benchmark"
+    local loader="gramine-direct"
+    if [ "$SGX_ENABLED" -eq 1 ]; then
+        loader="gramine-sgx"
     fi
+
+    echo -e "${BLUE}Running $mode throughput natively...${NC}"
+    $binary $ITERATIONS --workers=$WORKERS --threads=1 $NATIVE_KEYS
+    echo -e "${BLUE}Running $mode throughput under $loader...${NC}"
+    $loader $binary $ITERATIONS --workers=$WORKERS --threads=1 $KEYS
     echo "--------------------------------------------"
 }
 
+# Time to first ciphertext: keygen against loading the saved context and
+# keys, inside one process and for a whole launch
+run_startup() {
+    local loader=""
+    local dir="keys-native"
+    if [ "$SGX_ENABLED" -eq 1 ]; then
+        loader="gramine-sgx"
+        dir="keys"
+    fi
+
+    echo -e "${BLUE}Running start-up benchmark...${NC}"
+    $loader ./encrypt_benchmark 1 --keys=$dir --startup=3
+    for launch in keygen load; do
+        if [ "$launch" == "keygen" ]; then
+            rm -f $dir/*
+        fi
+        local start=$(date +%s%N)
+        $loader ./encrypt_benchmark 1 --keys=$dir > /dev/null 2>&1
+        echo "Whole launch with $launch: $(( ($(date +%s%N) - start) / 1000000 )) ms"
+    done
+    echo "--------------------------------------------"
+}
+
+# Per-op latency and heap for every ring and depth, outside and inside the
+# enclave; heap growth against enclave size shows where EPC paging starts
+run_evaluation() {
+    local loader="gramine-direct"
+    if [ "$SGX_ENABLED" -eq 1 ]; then
+        loader="gramine-sgx"
+    fi
+
+    for ring in $EVAL_RINGS; do
+        for depth in $EVAL_DEPTHS; do
+            echo -e "${BLUE}Running evaluation, ring $ring, depth $depth, natively...${NC}"
+            ./eval_benchmark $EVAL_ITERATIONS $ring 30 $depth $NATIVE_KEYS | grep -A 5 '^op,'
+            report_failure "native evaluation" "${PIPESTATUS[0]}"
+            echo -e "${BLUE}Running evaluation, ring $ring, depth $depth, under $loader...${NC}"
+            $loader ./eval_benchmark $EVAL_ITERATIONS $ring 30 $depth $KEYS | grep -A 5 '^op,'
+            report_failure "$loader evaluation" "${PIPESTATUS[0]}"
+        done
+    done
+    echo "--------------------------------------------"
+}
+
+run_startup
+
 # Run encryption benchmark
 run_benchmark "encrypt"
 
 # Run decryption benchmark
 run_benchmark "decrypt"
 
+if [ "$WORKERS" -gt 1 ]; then
+    run_scaling "encrypt"
+    run_scaling "decrypt"
+fi
+
+run_evaluation
+
+if [ "$FAILURES" -gt 0 ]; then
+    echo -e "${RED}Benchmark finished with $FAILURES failed run(s)${NC}"
+    exit 1
+fi
 echo -e "${YELLOW}Benchmark complete!${NC}"
@@ -1,5 +1,6 @@
 // decrypt_benchmark.cpp
 #include "openfhe.h"
+#include "benchmark_common.h"
 #include <chrono>
 #include <iostream>
 
@@ -7,25 +8,20 @@ using namespace lbcrypto;
 using namespace std::chrono;
 
 int main(int argc, char* argv[]) {
-    int iterations = (argc > 1) ? std::stoi(argv[1]) : 10000; // Default to 10000 if not provided
+    BenchmarkParams params = parse_params(argc, argv);
+    if (params.startup > 0) return run_startup(params);
+    int iterations = params.iterations;
     std::cout << "Running decryption benchmark for " << iterations << " iterations..." << std::endl;
 
-    // Setup parameters similar to the custom CKKS implementation
-    CCParams<CryptoContextCKKSRNS> parameters;
-    parameters.SetMultiplicativeDepth(1);
-    parameters.SetBatchSize(8192);
-    parameters.SetScalingModSize(30);
-
-    CryptoContext<DCRTPoly> cryptoContext = GenCryptoContext(parameters);
-    cryptoContext->Enable(PKE);
-
-    // Generate keys
-    std::cout << "Generating keys..." << std::endl;
-    KeyPair<DCRTPoly> keyPair = cryptoContext->KeyGen();
+    // Setup parameters similar to the custom CKKS implementation; with
+    // --keys, reuse the context and keys of an earlier launch
+    KeyPair<DCRTPoly> keyPair;
+    CryptoContext<DCRTPoly> cryptoContext = setup_context(params, keyPair);
+    if (!cryptoContext) return 1;
 
     // Prepare test data
-    std::vector<double> vectorOfDoubles(4096, 0.0); // Half of poly degree
-    for (int i = 0; i < 4096; i++) {
+    std::vector<double> vectorOfDoubles(params.messageLength, 0.0);
+    for (uint32_t i = 0; i < params.messageLength; i++) {
         vectorOfDoubles[i] = i * 1.1;
     }
 
@@ -34,12 +30,30 @@ int main(int argc, char* argv[]) {
     // First encrypt once to get a valid ciphertext
     auto ciphertext = cryptoContext->Encrypt(keyPair.publicKey, plaintext);
 
+    std::vector<double> samples;
+    if (params.workers > 0) {
+        // Throughput mode; the workers share the ciphertext read-only
+        std::cout << "\nDecryption throughput, ring dimension " << cryptoContext->GetRingDimension() << ":"
+                  << std::endl;
+        run_scaling(params, [&](int) {
+            Plaintext decryptedPlaintext;
+            cryptoContext->Decrypt(keyPair.secretKey, ciphertext, &decryptedPlaintext);
+        }, samples);
+        if (!write_samples(params.samples, samples)) {
+            std::cerr << "Cannot write " << params.samples << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // Run benchmark
     auto start = high_resolution_clock::now();
 
     for (int i = 0; i < iterations; i++) {
+        auto sent = high_resolution_clock::now();
         Plaintext decryptedPlaintext;
         cryptoContext->Decrypt(keyPair.secretKey, ciphertext, &decryptedPlaintext);
+        samples.push_back(elapsed_ms(sent));
     }
 
     auto end = high_resolution_clock::now();
@@ -47,9 +61,14 @@ int main(int argc, char* argv[]) {
 
     // Output results
     std::cout << "\nDecryption benchmark results:" << std::endl;
+    std::cout << "Ring dimension: " << cryptoContext->GetRingDimension() << std::endl;
     std::cout << "Total time: " << duration << " ms" << std::endl;
     std::cout << "Average time per decryption: " << (double)duration / iterations << " ms" << std::endl;
     std::cout << "Operations per second: " << (iterations * 1000.0) / duration << std::endl;
 
+    if (!write_samples(params.samples, samples)) {
+        std::cerr << "Cannot write " << params.samples << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,172 @@
+// eval_benchmark.cpp
+#include "openfhe.h"
+#include "benchmark_common.h"
+#include <malloc.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+using namespace lbcrypto;
+using namespace std::chrono;
+
+// Extra flag: --op=add|mult|rescale|rotate|inner|all (default all)
+
+// Bytes the allocator has handed out and not yet got back; inside Gramine
+// this is the enclave heap the operations touch
+static double heap_mb() {
+    struct mallinfo2 info = mallinfo2();
+    return (info.uordblks + info.hblkhd) / 1e6;
+}
+
+// Peak resident set from /proc/self/status, or 0 where the loader does not
+// report it
+static double peak_rss_mb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::stod(line.substr(6)) / 1e3;
+    }
+    return 0.0;
+}
+
+// Relinearization, rotation-by-1 and summation keys: loaded from --keys
+// when the key pair was loaded too and an earlier launch saved them there,
+// otherwise generated for this key pair and saved
+static bool setup_eval_keys(const BenchmarkParams& params, const CryptoContext<DCRTPoly>& cryptoContext,
+                            const KeyPair<DCRTPoly>& keyPair, bool keyPairLoaded) {
+    if (keyPairLoaded) {
+        std::ifstream mult(key_file(params, "mult").c_str(), std::ios::binary);
+        std::ifstream rotate(key_file(params, "rotate").c_str(), std::ios::binary);
+        if (mult && rotate && cryptoContext->DeserializeEvalMultKey(mult, SerType::BINARY) &&
+            cryptoContext->DeserializeEvalAutomorphismKey(rotate, SerType::BINARY)) {
+            return true;
+        }
+    }
+
+    std::cout << "Generating evaluation keys..." << std::endl;
+    cryptoContext->EvalMultKeyGen(keyPair.secretKey);
+    cryptoContext->EvalRotateKeyGen(keyPair.secretKey, {1});
+    cryptoContext->EvalSumKeyGen(keyPair.secretKey);
+    if (params.keys.empty()) return true;
+
+    std::ofstream mult(key_file(params, "mult").c_str(), std::ios::binary);
+    std::ofstream rotate(key_file(params, "rotate").c_str(), std::ios::binary);
+    if (!cryptoContext->SerializeEvalMultKey(mult, SerType::BINARY) ||
+        !cryptoContext->SerializeEvalAutomorphismKey(rotate, SerType::BINARY)) {
+        std::cerr << "Cannot save the evaluation keys to " << params.keys << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct EvalOp {
+    std::string name;
+    std::function<Ciphertext<DCRTPoly>()> run;
+    std::vector<double> expected;   // slot values of the result
+    uint32_t checked;               // leading slots compared against `expected`
+};
+
+int main(int argc, char* argv[]) {
+    BenchmarkParams params = parse_params(argc, argv);
+    params.evaluation = true;
+    if (params.startup > 0) return run_startup(params);
+    std::string selected = get_option(argc, argv, "op", "all");
+    int iterations = params.iterations;
+    const std::vector<std::string> names = {"add", "mult", "rescale", "rotate", "inner"};
+    if (selected != "all" && std::find(names.begin(), names.end(), selected) == names.end()) {
+        std::cerr << "Unknown op: " << selected << std::endl;
+        return 1;
+    }
+    if (selected == "all" && !params.samples.empty()) {
+        std::cerr << "--samples needs a single --op" << std::endl;
+        return 1;
+    }
+    if (params.depth < 1) {
+        std::cerr << "Evaluation needs depth >= 1" << std::endl;
+        return 1;
+    }
+    std::cout << "Running evaluation benchmark for " << iterations << " iterations..." << std::endl;
+
+    // Same ring and chain as the other benchmarks, with manual rescaling;
+    // with --keys, reuse the context and all keys of an earlier launch
+    KeyPair<DCRTPoly> keyPair;
+    bool loaded = false;
+    CryptoContext<DCRTPoly> cryptoContext = setup_context(params, keyPair, &loaded);
+    if (!cryptoContext || !setup_eval_keys(params, cryptoContext, keyPair, loaded)) return 1;
+    double setupHeap = heap_mb();
+
+    // Inputs below 1, so the inner product over every slot stays well
+    // inside the first modulus
+    std::vector<double> x(params.slots, 0.0), y(params.slots, 0.0);
+    for (uint32_t i = 0; i < params.messageLength; i++) {
+        x[i] = (i % 16) / 16.0;
+        y[i] = ((i * 7) % 16) / 16.0;
+    }
+    auto ctX = cryptoContext->Encrypt(keyPair.publicKey, cryptoContext->MakeCKKSPackedPlaintext(x));
+    auto ctY = cryptoContext->Encrypt(keyPair.publicKey, cryptoContext->MakeCKKSPackedPlaintext(y));
+    auto product = cryptoContext->EvalMult(ctX, ctY);
+
+    std::vector<double> sum(params.slots), prod(params.slots), rotated(params.slots);
+    double dot = 0.0;
+    for (uint32_t i = 0; i < params.slots; i++) {
+        sum[i] = x[i] + y[i];
+        prod[i] = x[i] * y[i];
+        rotated[i] = x[(i + 1) % params.slots];
+        dot += x[i] * y[i];
+    }
+
+    std::vector<EvalOp> ops = {
+        {"add", [&]() { return cryptoContext->EvalAdd(ctX, ctY); }, sum, params.slots},
+        {"mult", [&]() { return cryptoContext->EvalMult(ctX, ctY); }, prod, params.slots},
+        {"rescale", [&]() { return cryptoContext->Rescale(product); }, prod, params.slots},
+        {"rotate", [&]() { return cryptoContext->EvalRotate(ctX, 1); }, rotated, params.slots},
+        {"inner", [&]() { return cryptoContext->EvalInnerProduct(ctX, ctY, params.slots); },
+         std::vector<double>(1, dot), 1},
+    };
+
+    // heap_mb is the largest heap seen after any operation (sampled outside
+    // the timed region); setup_mb is the heap with context, keys and inputs
+    std::cout << "\nEvaluation benchmark results, ring dimension " << cryptoContext->GetRingDimension()
+              << ", depth " << params.depth << ":" << std::endl;
+    std::cout << "op,iterations,mean_ms,p50_ms,p99_ms,ops_per_sec,max_error,setup_mb,heap_mb,peak_rss_mb"
+              << std::endl;
+    std::vector<double> samples;
+    for (size_t o = 0; o < ops.size(); o++) {
+        if (selected != "all" && ops[o].name != selected) continue;
+
+        std::vector<double> latencies;
+        double peakHeap = setupHeap;
+        Ciphertext<DCRTPoly> result;
+        for (int i = 0; i < iterations; i++) {
+            auto sent = high_resolution_clock::now();
+            result = ops[o].run();
+            latencies.push_back(elapsed_ms(sent));
+            peakHeap = std::max(peakHeap, heap_mb());
+        }
+
+        double maxError = 0.0;
+        if (result) {
+            Plaintext decrypted;
+            cryptoContext->Decrypt(keyPair.secretKey, result, &decrypted);
+            std::vector<double> values = decrypted->GetRealPackedValue();
+            for (uint32_t i = 0; i < ops[o].checked && i < values.size(); i++) {
+                maxError = std::max(maxError, std::fabs(values[i] - ops[o].expected[i]));
+            }
+        }
+
+        samples = latencies;
+        std::sort(latencies.begin(), latencies.end());
+        double total = 0.0;
+        for (size_t i = 0; i < latencies.size(); i++) total += latencies[i];
+        double mean = latencies.empty() ? 0.0 : total / latencies.size();
+        std::cout << ops[o].name << "," << iterations << "," << mean << "," << percentile(latencies, 0.50) << ","
+                  << percentile(latencies, 0.99) << "," << (total > 0.0 ? iterations * 1000.0 / total : 0.0)
+                  << "," << maxError << "," << setupHeap << "," << peakHeap << "," << peak_rss_mb() << std::endl;
+    }
+
+    if (!write_samples(params.samples, samples)) {
+        std::cerr << "Cannot write " << params.samples << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,11 +1,27 @@
 #include "sgx_urts.h"
 #include "Enclave_u.h"
+#include "CKKSLayout.h"
+#include "CKKSStats.h"
+#include "WireFormat.h"
+#include "Server.h"
+#include "AsyncRing.h"
+#include "Refill.h"
+#include "FileStream.h"
+#include "BenchUtil.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdio>
 #include <string>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <fstream>
 
 sgx_enclave_id_t global_eid = 0;
+// Context the modes work on (ecall_init_ckks)
+uint32_t global_context = 0;
 
 int initialize_enclave() {
     sgx_launch_token_t token = {0};
@@ -15,17 +31,107 @@ int initialize_enclave() {
     return (ret == SGX_SUCCESS) ? 0 : -1;
 }
 
+// Splits `iterations` encryptions or decryptions across `threads` host threads,
+// each with its own buffers, issuing concurrent ecalls into the one enclave.
+// Appends every ecall's latency to `latencies`. Returns aggregate operations
+// per second, or a negative value on failure.
+double run_worker_pool(bool encrypting, int threads, int iterations, int slots,
+                       const std::vector<double>& msg_real, const std::vector<double>& msg_imag,
+                       const std::vector<int64_t>& ciphertext, std::vector<double>& latencies) {
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    std::vector<std::vector<double> > per_thread(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        int share = iterations / threads + ((t < iterations % threads) ? 1 : 0);
+        workers.push_back(std::thread([&, t, share]() {
+            std::vector<int64_t> ct(ciphertext);
+            std::vector<double> out_real(slots), out_imag(slots);
+            sgx_status_t ret, status;
+            for (int i = 0; i < share && !failed; i++) {
+                std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+                if (encrypting) {
+                    status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                          slots, ct.data(), (uint32_t)ct.size());
+                } else {
+                    status = ecall_decrypt(global_eid, &ret, global_context, ct.data(), (uint32_t)ct.size(),
+                                          out_real.data(), out_imag.data(), slots);
+                }
+                per_thread[t].push_back(elapsed_ms(sent));
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) failed = true;
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int t = 0; t < threads; t++) {
+        latencies.insert(latencies.end(), per_thread[t].begin(), per_thread[t].end());
+    }
+
+    return failed ? -1.0 : iterations / seconds;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " [genkeys|encrypt|decrypt] [iterations] [polyDegree] [scale]" << std::endl;
+    // Positional arguments; --name=value flags may appear anywhere
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).compare(0, 2, "--") != 0) args.push_back(argv[i]);
+    }
+
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [genkeys|encrypt|decrypt|encrypt-symmetric|decrypt-symmetric|"
+                  << "encrypt-batch|decrypt-batch|throughput|async|export|import|encrypt-file|decrypt-file|evaluate|"
+                  << "contexts|encode|memstats|stats|serve]"
+                  << " [iterations] [polyDegree] [scale] [depth] [--batch=K] [--threads=N] [--op=encrypt|decrypt]"
+                  << " [--inflight=Q] [--pool=D] [--refillers=R] [--keys=name] [--contexts=K]"
+                  << " [--file=path] [--levels=L] [--scheme=public|symmetric] [--in=path] [--out=path]"
+                  << " [--format=binary|csv] [--socket=path] [--slots=S] [--plaintext-cache=C]"
+                  << " [--samples=path]" << std::endl;
         return -1;
     }
 
-    std::string mode = argv[1];
-    int iterations = (argc > 2) ? std::stoi(argv[2]) : 10000;
-    int polyDegree = (argc > 3) ? std::stoi(argv[3]) : 8192;
-    double scale = (argc > 4) ? std::stod(argv[4]) : (1 << 30);
-    int slots = polyDegree / 2;
+    std::string mode = args[0];
+    int iterations = (args.size() > 1) ? std::stoi(args[1]) : 10000;
+    int polyDegree = (args.size() > 2) ? std::stoi(args[2]) : 8192;
+    double scale = (args.size() > 3) ? std::stod(args[3]) : (1 << 30);
+    int depth = (args.size() > 4) ? std::stoi(args[4]) : 1;
+    int batch = std::stoi(get_option(argc, argv, "batch", "16"));
+    int threads = std::stoi(get_option(argc, argv, "threads", "16"));
+    std::string op = get_option(argc, argv, "op", "encrypt");
+    std::string wire_file = get_option(argc, argv, "file", "ciphertexts.ckw");
+    int levels = std::stoi(get_option(argc, argv, "levels", "0"));
+    std::string scheme = get_option(argc, argv, "scheme", "public");
+    // Plaintext and stream files of encrypt-file and decrypt-file
+    std::string in_path = get_option(argc, argv, "in", "");
+    std::string out_path = get_option(argc, argv, "out", "");
+    std::string format = get_option(argc, argv, "format", "");
+    std::string socket_path = get_option(argc, argv, "socket", CKKS_RPC_SOCKET);
+    // Requests kept outstanding on the async request ring
+    int inflight = std::stoi(get_option(argc, argv, "inflight", "64"));
+    // Precomputed encryptions of zero kept ready for encrypt, and the
+    // enclave threads refilling them; 0 encrypts entirely online
+    int pool = std::stoi(get_option(argc, argv, "pool", "0"));
+    int refillers = std::stoi(get_option(argc, argv, "refillers", "1"));
+    // Encoded plaintexts the enclave keeps for messages it has seen; 0
+    // encodes every message afresh
+    int plaintext_cache = std::stoi(get_option(argc, argv, "plaintext-cache", "0"));
+    // Key set: <name>_secret_key.bin, <name>_public_key.bin, <name>_relin_key.bin
+    std::string key_name = get_option(argc, argv, "keys", "ckks");
+    // Contexts the contexts mode keeps alive side by side
+    int contexts = std::stoi(get_option(argc, argv, "contexts", "4"));
+    // Message slots; fewer than polyDegree / 2 (a power of two) packs sparsely
+    int slots = std::stoi(get_option(argc, argv, "slots", std::to_string(polyDegree / 2)));
+    // Per-operation latencies of the timed modes go here, one per line
+    std::string samples_file = get_option(argc, argv, "samples", "");
+    std::vector<double> samples;
+
+    if (batch < 1 || threads < 1 || slots < 1 || inflight < 1 || pool < 0 || refillers < 1 || contexts < 1 ||
+        plaintext_cache < 0) {
+        std::cerr << "Batch size, thread count, slots, requests in flight and refillers must be positive"
+                  << std::endl;
+        return -1;
+    }
 
     if (initialize_enclave() < 0) {
         std::cerr << "Failed to initialize enclave." << std::endl;
@@ -35,7 +141,7 @@ int main(int argc, char* argv[]) {
     sgx_status_t ret, status;
 
     // Initialize CKKS
-    status = ecall_init_ckks(global_eid, &ret, polyDegree, scale);
+    status = ecall_init_ckks(global_eid, &ret, polyDegree, scale, depth, slots, &global_context);
     if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
         std::cerr << "Failed to initialize CKKS" << std::endl;
         sgx_destroy_enclave(global_eid);
@@ -44,7 +150,7 @@ int main(int argc, char* argv[]) {
 
     if (mode == "genkeys") {
         // Generate keys and save them
-        status = ecall_generate_keys(global_eid, &ret);
+        status = ecall_generate_keys(global_eid, &ret, global_context);
         if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
             std::cerr << "Failed to generate keys" << std::endl;
             sgx_destroy_enclave(global_eid);
@@ -52,7 +158,7 @@ int main(int argc, char* argv[]) {
         }
 
         // Save keys to file
-        status = ecall_save_keys(global_eid, &ret);
+        status = ecall_save_keys(global_eid, &ret, global_context, key_name.c_str());
         if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
             std::cerr << "Failed to save keys" << std::endl;
             sgx_destroy_enclave(global_eid);
@@ -63,7 +169,7 @@ int main(int argc, char* argv[]) {
     }
     else {
         // Load keys from file
-        status = ecall_load_keys(global_eid, &ret);
+        status = ecall_load_keys(global_eid, &ret, global_context, key_name.c_str());
         if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
             std::cerr << "Failed to load keys" << std::endl;
             sgx_destroy_enclave(global_eid);
@@ -80,19 +186,40 @@ int main(int argc, char* argv[]) {
             msg_imag[i] = i * 0.5;
         }
 
-        // Prepare ciphertext buffer
-        uint32_t ct_size = 2 * polyDegree;
+        // Prepare ciphertext buffer: header plus (depth + 1) RNS limbs per component
+        uint32_t ct_size = (uint32_t)CKKS_CT_WORDS(polyDegree, depth + 1);
         std::vector<int64_t> ciphertext(ct_size, 0);
 
         // Prepare result buffers for decryption
         std::vector<double> result_real(slots, 0.0);
         std::vector<double> result_imag(slots, 0.0);
 
+        // Filled before the mode runs; its counters cover the mode alone
+        std::chrono::steady_clock::time_point pool_start = std::chrono::steady_clock::now();
+        if (pool > 0) {
+            if (!startRefill(global_eid, global_context, (uint32_t)pool, refillers)) {
+                std::cerr << "Failed to fill the zero pool" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            pool_start = std::chrono::steady_clock::now();
+        }
+        if (plaintext_cache > 0) {
+            status = ecall_configure_plaintext_cache(global_eid, &ret, global_context, (uint32_t)plaintext_cache);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Failed to configure the plaintext cache" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+        }
+
         if (mode == "encrypt") {
             // Run encryption benchmark
             for (int i = 0; i < iterations; i++) {
-                status = ecall_encrypt(global_eid, &ret, msg_real.data(), msg_imag.data(),
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
                                       slots, ciphertext.data(), ct_size);
+                samples.push_back(elapsed_ms(start));
                 if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
                     std::cerr << "Encryption failed at iteration " << i << std::endl;
                     sgx_destroy_enclave(global_eid);
@@ -102,7 +229,7 @@ int main(int argc, char* argv[]) {
         }
         else if (mode == "decrypt") {
             // First encrypt once to get a valid ciphertext
-            status = ecall_encrypt(global_eid, &ret, msg_real.data(), msg_imag.data(),
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
                                   slots, ciphertext.data(), ct_size);
             if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
                 std::cerr << "Initial encryption failed" << std::endl;
@@ -112,8 +239,10 @@ int main(int argc, char* argv[]) {
 
             // Run decryption benchmark
             for (int i = 0; i < iterations; i++) {
-                status = ecall_decrypt(global_eid, &ret, ciphertext.data(), ct_size,
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                status = ecall_decrypt(global_eid, &ret, global_context, ciphertext.data(), ct_size,
                                       result_real.data(), result_imag.data(), slots);
+                samples.push_back(elapsed_ms(start));
                 if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
                     std::cerr << "Decryption failed at iteration " << i << std::endl;
                     sgx_destroy_enclave(global_eid);
@@ -121,11 +250,592 @@ int main(int argc, char* argv[]) {
                 }
             }
         }
+        else if (mode == "encrypt-symmetric" || mode == "decrypt-symmetric") {
+            // Secret-key ciphertexts: c0 and a 32-byte seed instead of c1
+            uint32_t seeded_size = (uint32_t)CKKS_CT_SEEDED_WORDS(polyDegree, depth + 1);
+            std::vector<int64_t> seeded(seeded_size, 0);
+            bool encrypting = (mode == "encrypt-symmetric");
+
+            for (int i = 0; i < (encrypting ? iterations : 1); i++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                status = ecall_encrypt_symmetric(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                                slots, seeded.data(), seeded_size);
+                if (encrypting) samples.push_back(elapsed_ms(start));
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Symmetric encryption failed at iteration " << i << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+            }
+
+            for (int i = 0; i < (encrypting ? 0 : iterations); i++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                status = ecall_decrypt(global_eid, &ret, global_context, seeded.data(), seeded_size,
+                                      result_real.data(), result_imag.data(), slots);
+                samples.push_back(elapsed_ms(start));
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Decryption failed at iteration " << i << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+            }
+        }
+        else if (mode == "encrypt-batch" || mode == "decrypt-batch") {
+            // K messages or ciphertexts per ecall, laid out back to back;
+            // iterations counts individual operations, not ecalls
+            std::vector<double> batch_real, batch_imag;
+            for (int k = 0; k < batch; k++) {
+                batch_real.insert(batch_real.end(), msg_real.begin(), msg_real.end());
+                batch_imag.insert(batch_imag.end(), msg_imag.begin(), msg_imag.end());
+            }
+            std::vector<int64_t> batch_ct((size_t)ct_size * batch, 0);
+            std::vector<double> batch_result_real((size_t)slots * batch, 0.0);
+            std::vector<double> batch_result_imag((size_t)slots * batch, 0.0);
+
+            bool encrypting = (mode == "encrypt-batch");
+            if (!encrypting) {
+                // Encrypt one batch to get valid ciphertexts
+                status = ecall_encrypt_batch(global_eid, &ret, global_context, batch_real.data(), batch_imag.data(),
+                                            (uint32_t)batch_real.size(), slots,
+                                            batch_ct.data(), (uint32_t)batch_ct.size(), ct_size, batch);
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Initial batch encryption failed" << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+            }
+
+            for (int done = 0; done < iterations; done += batch) {
+                uint32_t k = (uint32_t)std::min(batch, iterations - done);
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                if (encrypting) {
+                    status = ecall_encrypt_batch(global_eid, &ret, global_context, batch_real.data(),
+                                                batch_imag.data(), k * slots, slots, batch_ct.data(), k * ct_size,
+                                                ct_size, k);
+                } else {
+                    status = ecall_decrypt_batch(global_eid, &ret, global_context, batch_ct.data(), k * ct_size,
+                                                ct_size, batch_result_real.data(), batch_result_imag.data(),
+                                                k * slots, slots, k);
+                }
+                // Per operation: the ecall is shared by its k operations
+                samples.insert(samples.end(), k, elapsed_ms(start) / k);
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Batch " << (encrypting ? "encryption" : "decryption")
+                              << " failed at operation " << done << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+            }
+        }
+        else if (mode == "throughput") {
+            // Aggregate ops/sec for 1, 2, 4, ... host threads up to --threads;
+            // the enclave needs at least that many TCSs (ENCLAVE_TCS)
+            if (op != "encrypt" && op != "decrypt") {
+                std::cerr << "Unknown operation: " << op << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                  slots, ciphertext.data(), ct_size);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Initial encryption failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            std::cout << "threads,ops_per_sec,speedup" << std::endl;
+            double single = 0.0;
+            for (int t = 1; t <= threads; t = (t * 2 > threads && t < threads) ? threads : t * 2) {
+                // Samples are kept for the largest thread count only
+                samples.clear();
+                double rate = run_worker_pool(op == "encrypt", t, iterations, slots, msg_real, msg_imag, ciphertext,
+                                              samples);
+                if (rate < 0.0) {
+                    std::cerr << "Throughput run failed with " << t << " threads" << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+                if (t == 1) single = rate;
+                std::cout << t << "," << rate << "," << rate / single << std::endl;
+            }
+        }
+        else if (mode == "async") {
+            // --threads enclave workers poll a shared request ring; the main
+            // thread keeps --inflight requests outstanding on it
+            if (op != "encrypt" && op != "decrypt") {
+                std::cerr << "Unknown operation: " << op << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                  slots, ciphertext.data(), ct_size);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Initial encryption failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            double rate = runAsync(global_eid, global_context, op == "encrypt", iterations, threads, inflight,
+                                   msg_real, msg_imag, ciphertext, samples);
+            if (rate < 0.0) {
+                std::cerr << "Async run failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            LatencySummary summary = summarize(samples);
+            std::cout << "async " << op << ": " << threads << " enclave workers, " << inflight << " in flight, "
+                      << rate << " ops/sec, mean " << summary.mean << " ms, p50 " << summary.p50
+                      << " ms, p99 " << summary.p99 << " ms" << std::endl;
+        }
+        else if (mode == "export") {
+            // Encrypt `iterations` messages and stream them to one wire file,
+            // keeping --levels limbs (0 keeps all)
+            bool symmetric = (scheme == "symmetric");
+            uint64_t moduli[MAX_MODULI];
+            uint32_t num_moduli = 0;
+            status = ecall_get_moduli(global_eid, &ret, global_context, moduli, MAX_MODULI, &num_moduli);
+            std::ofstream out(wire_file.c_str(), std::ios::binary);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS || !out) {
+                std::cerr << "Cannot export to " << wire_file << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            uint32_t export_size = symmetric ? (uint32_t)CKKS_CT_SEEDED_WORDS(polyDegree, depth + 1) : ct_size;
+            std::vector<int64_t> exported(export_size, 0);
+            for (int i = 0; i < iterations; i++) {
+                if (symmetric) {
+                    status = ecall_encrypt_symmetric(global_eid, &ret, global_context, msg_real.data(),
+                                                    msg_imag.data(), slots, exported.data(), export_size);
+                } else {
+                    status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                          slots, exported.data(), export_size);
+                }
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS ||
+                    !writeWireCiphertext(out, exported.data(), polyDegree, moduli, (uint32_t)levels)) {
+                    std::cerr << "Export failed at iteration " << i << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+            }
+
+            size_t wire_bytes = (size_t)out.tellp();
+            std::cout << "Exported " << iterations << " ciphertexts to " << wire_file << ": "
+                      << wire_bytes / iterations << " bytes each (in-memory "
+                      << export_size * sizeof(int64_t) << " bytes)" << std::endl;
+        }
+        else if (mode == "import") {
+            // Decrypt every ciphertext in a wire file and check it against the test message
+            std::ifstream in(wire_file.c_str(), std::ios::binary);
+            if (!in) {
+                std::cerr << "Cannot open " << wire_file << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            std::vector<int64_t> imported;
+            uint32_t wire_degree = 0;
+            int count = 0;
+            double max_error = 0.0;
+            while (in.peek() != EOF) {
+                if (readWireCiphertext(in, imported, &wire_degree) && wire_degree == (uint32_t)polyDegree) {
+                    status = ecall_decrypt(global_eid, &ret, global_context, imported.data(),
+                                          (uint32_t)imported.size(), result_real.data(), result_imag.data(), slots);
+                } else {
+                    status = SGX_ERROR_INVALID_PARAMETER;
+                }
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Import failed at ciphertext " << count << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+                for (int i = 0; i < slots; i++) {
+                    max_error = std::max(max_error, std::fabs(result_real[i] - msg_real[i]));
+                    max_error = std::max(max_error, std::fabs(result_imag[i] - msg_imag[i]));
+                }
+                count++;
+            }
+            std::cout << "Imported " << count << " ciphertexts, max error " << max_error << std::endl;
+        }
+        else if (mode == "encrypt-file" || mode == "decrypt-file") {
+            // Stream a file of doubles into chunked ciphertexts, or back
+            bool encrypting = (mode == "encrypt-file");
+            int stream_format = -1;
+            if (format == "binary") {
+                stream_format = CKKS_STREAM_BINARY;
+            } else if (format == "csv") {
+                stream_format = CKKS_STREAM_CSV;
+            } else if (!format.empty()) {
+                std::cerr << "Unknown format: " << format << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            if (in_path.empty()) {
+                std::cerr << mode << " needs --in=path" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            if (out_path.empty()) out_path = in_path + (encrypting ? ".ckfs" : ".plain");
+
+            StreamStats stream;
+            bool ok;
+            if (encrypting) {
+                ok = encryptFile(global_eid, global_context, in_path, out_path,
+                                 (stream_format < 0) ? CKKS_STREAM_BINARY : stream_format, polyDegree,
+                                 (uint32_t)slots, (uint32_t)levels, threads, &stream);
+            } else {
+                ok = decryptFile(global_eid, global_context, in_path, out_path, stream_format, polyDegree,
+                                 (uint32_t)slots, threads, &stream);
+            }
+            if (!ok) {
+                std::cerr << mode << " failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            std::cout << mode << ": " << stream.values << " values in " << stream.chunks << " chunks, "
+                      << stream.plainBytes / 1e6 << " MB plaintext, " << stream.cipherBytes / 1e6
+                      << " MB ciphertext, " << stream.seconds << " s, "
+                      << stream.plainBytes / 1e6 / std::max(stream.seconds, 1e-9) << " MB/s with " << threads
+                      << " enclave threads" << std::endl;
+        }
+        else if (mode == "evaluate") {
+            // Time add, plaintext multiply and ciphertext multiply (each product
+            // rescaled once) on x and y, then check the decrypted results
+            if (depth < 1) {
+                std::cerr << "evaluate needs depth >= 1" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            std::vector<double> y_real(slots), y_imag(slots);
+            for (int i = 0; i < slots; i++) {
+                y_real[i] = 1.0 - (double)i / slots;
+                y_imag[i] = 0.25;
+            }
+            uint32_t rescaled_size = (uint32_t)CKKS_CT_WORDS(polyDegree, depth);
+            std::vector<int64_t> ct_y(ct_size), sum(ct_size), product(ct_size), rescaled(rescaled_size);
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                  slots, ciphertext.data(), ct_size);
+            if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                status = ecall_encrypt(global_eid, &ret, global_context, y_real.data(), y_imag.data(), slots,
+                                      ct_y.data(), ct_size);
+            }
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Initial encryption failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            const char* names[3] = {"add", "multiply-plain+rescale", "multiply+rescale"};
+            for (int op_index = 0; op_index < 3; op_index++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int i = 0; i < iterations && status == SGX_SUCCESS && ret == SGX_SUCCESS; i++) {
+                    if (op_index == 0) {
+                        status = ecall_add(global_eid, &ret, global_context, ciphertext.data(), ct_size, ct_y.data(),
+                                          ct_size, sum.data(), ct_size);
+                        continue;
+                    }
+                    if (op_index == 1) {
+                        status = ecall_multiply_plain(global_eid, &ret, global_context, ciphertext.data(), ct_size,
+                                                     y_real.data(), y_imag.data(), slots, product.data(), ct_size);
+                    } else {
+                        status = ecall_multiply(global_eid, &ret, global_context, ciphertext.data(), ct_size,
+                                               ct_y.data(), ct_size, product.data(), ct_size);
+                    }
+                    if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                        status = ecall_rescale(global_eid, &ret, global_context, product.data(), ct_size,
+                                              rescaled.data(), rescaled_size);
+                    }
+                }
+                double elapsed = elapsed_ms(start);
+
+                // Decrypt the last result against the expected slot values
+                std::vector<int64_t>& result = (op_index == 0) ? sum : rescaled;
+                if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                    status = ecall_decrypt(global_eid, &ret, global_context, result.data(), (uint32_t)result.size(),
+                                          result_real.data(), result_imag.data(), slots);
+                }
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cerr << "Evaluation failed: " << names[op_index] << std::endl;
+                    sgx_destroy_enclave(global_eid);
+                    return -1;
+                }
+
+                // Relative to the largest slot: a product carries each
+                // operand's encryption error scaled by the other operand
+                double max_error = 0.0, max_value = 0.0;
+                for (int i = 0; i < slots; i++) {
+                    double expected_real = msg_real[i] + y_real[i];
+                    double expected_imag = msg_imag[i] + y_imag[i];
+                    if (op_index > 0) {
+                        expected_real = msg_real[i] * y_real[i] - msg_imag[i] * y_imag[i];
+                        expected_imag = msg_real[i] * y_imag[i] + msg_imag[i] * y_real[i];
+                    }
+                    max_error = std::max(max_error, std::fabs(result_real[i] - expected_real));
+                    max_error = std::max(max_error, std::fabs(result_imag[i] - expected_imag));
+                    max_value = std::max(max_value, std::max(std::fabs(expected_real), std::fabs(expected_imag)));
+                }
+                std::cout << names[op_index] << ": " << elapsed / std::max(iterations, 1) << " ms/op, max relative error "
+                          << max_error / max_value << std::endl;
+            }
+        }
+        else if (mode == "contexts") {
+            // The loaded context plus K - 1 tenants with their own keys,
+            // alternating between N and N/2, served round robin by one
+            // enclave without rebuilding any of them
+            std::vector<uint32_t> handles(1, global_context);
+            std::vector<int> degrees(1, polyDegree);
+            bool ok = true;
+            for (int c = 1; c < contexts && ok; c++) {
+                int degree = (c % 2 == 0 || polyDegree / 2 < MIN_POLY_DEGREE) ? polyDegree : polyDegree / 2;
+                uint64_t peak_stack = 0, peak_heap = 0, heap_before = 0, heap_after = 0;
+                ecall_get_memory_stats(global_eid, &ret, &peak_stack, &peak_heap, &heap_before);
+
+                uint32_t handle = 0;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                status = ecall_init_ckks(global_eid, &ret, degree, scale, depth, std::min(slots, degree / 2),
+                                         &handle);
+                ok = (status == SGX_SUCCESS && ret == SGX_SUCCESS);
+                if (ok) {
+                    handles.push_back(handle);
+                    degrees.push_back(degree);
+                    status = ecall_generate_keys(global_eid, &ret, handle);
+                    ok = (status == SGX_SUCCESS && ret == SGX_SUCCESS);
+                }
+                double setup_ms = elapsed_ms(start);
+                ecall_get_memory_stats(global_eid, &ret, &peak_stack, &peak_heap, &heap_after);
+                if (ok) {
+                    std::cout << "context " << c << ": N=" << degree << ", set up in " << setup_ms << " ms, +"
+                              << (heap_after - heap_before) / 1024 << " KB enclave heap" << std::endl;
+                }
+            }
+
+            double max_error = 0.0;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations && ok; i++) {
+                const size_t c = (size_t)i % handles.size();
+                const int context_slots = std::min(slots, degrees[c] / 2);
+                std::vector<int64_t> ct(CKKS_CT_WORDS(degrees[c], depth + 1));
+                std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+                status = ecall_encrypt(global_eid, &ret, handles[c], msg_real.data(), msg_imag.data(),
+                                      context_slots, ct.data(), (uint32_t)ct.size());
+                if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                    status = ecall_decrypt(global_eid, &ret, handles[c], ct.data(), (uint32_t)ct.size(),
+                                          result_real.data(), result_imag.data(), context_slots);
+                }
+                samples.push_back(elapsed_ms(sent));
+                ok = (status == SGX_SUCCESS && ret == SGX_SUCCESS);
+                for (int k = 0; k < context_slots && ok; k++) {
+                    max_error = std::max(max_error, std::fabs(result_real[k] - msg_real[k]));
+                    max_error = std::max(max_error, std::fabs(result_imag[k] - msg_imag[k]));
+                }
+            }
+            double mixed_ms = elapsed_ms(start);
+
+            // What each switch would cost with a single rebuilt context
+            double switch_ms = 0.0;
+            if (ok) {
+                uint32_t handle = 0;
+                start = std::chrono::steady_clock::now();
+                status = ecall_init_ckks(global_eid, &ret, polyDegree, scale, depth, slots, &handle);
+                if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                    status = ecall_load_keys(global_eid, &ret, handle, key_name.c_str());
+                    switch_ms = elapsed_ms(start);
+                    ecall_destroy_ckks(global_eid, &ret, handle);
+                }
+            }
+
+            for (size_t c = 1; c < handles.size(); c++) ecall_destroy_ckks(global_eid, &ret, handles[c]);
+            if (!ok) {
+                std::cerr << "Mixed workload failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            std::cout << "mixed: " << handles.size() << " contexts round robin, " << iterations
+                      << " encrypt+decrypt pairs, " << mixed_ms / std::max(iterations, 1)
+                      << " ms per pair, max error " << max_error << std::endl;
+            std::cout << "re-initialising and reloading keys instead: " << switch_ms << " ms per switch" << std::endl;
+        }
+        else if (mode == "memstats") {
+            // One encrypt/decrypt round trip, then report enclave memory high-water marks
+            ecall_reset_memory_stats(global_eid, &ret);
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                  slots, ciphertext.data(), ct_size);
+            if (status == SGX_SUCCESS && ret == SGX_SUCCESS) {
+                status = ecall_decrypt(global_eid, &ret, global_context, ciphertext.data(), ct_size,
+                                      result_real.data(), result_imag.data(), slots);
+            }
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Encrypt/decrypt round trip failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            uint64_t peak_stack = 0, peak_heap = 0, current_heap = 0;
+            ecall_get_memory_stats(global_eid, &ret, &peak_stack, &peak_heap, &current_heap);
+            std::cout << "Peak stack: " << peak_stack / 1024 << " KB" << std::endl;
+            std::cout << "Peak heap: " << peak_heap / 1024 << " KB" << std::endl;
+            std::cout << "Current heap: " << current_heap / 1024 << " KB" << std::endl;
+
+            const char* simd_names[3] = {"scalar", "AVX2", "AVX-512"};
+            uint32_t simd_level = 0;
+            ecall_get_simd_level(global_eid, &ret, &simd_level);
+            std::cout << "Vector kernels: " << simd_names[simd_level < 3 ? simd_level : 0] << std::endl;
+        }
+        else if (mode == "stats") {
+            // Per-ecall latency of encrypt and decrypt, then where the enclave
+            // spent its cycles; the phase counters are reset before each run
+            status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                  slots, ciphertext.data(), ct_size);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Initial encryption failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            const char* phase_names[CKKS_PHASE_COUNT] = CKKS_PHASE_NAMES;
+            const char* op_names[2] = {"encrypt", "decrypt"};
+            for (int op_index = 0; op_index < 2; op_index++) {
+                std::vector<double> latencies;
+                ecall_reset_stats(global_eid, &ret);
+                for (int i = 0; i < iterations; i++) {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    if (op_index == 0) {
+                        status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                              slots, ciphertext.data(), ct_size);
+                    } else {
+                        status = ecall_decrypt(global_eid, &ret, global_context, ciphertext.data(), ct_size,
+                                              result_real.data(), result_imag.data(), slots);
+                    }
+                    latencies.push_back(elapsed_ms(start));
+                    if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                        std::cerr << op_names[op_index] << " failed at iteration " << i << std::endl;
+                        sgx_destroy_enclave(global_eid);
+                        return -1;
+                    }
+                }
+
+                LatencySummary summary = summarize(latencies);
+                std::cout << op_names[op_index] << ": " << iterations << " ops, mean " << summary.mean << " ms, p50 "
+                          << summary.p50 << " ms, p99 " << summary.p99 << " ms" << std::endl;
+
+                uint64_t calls[CKKS_PHASE_COUNT], cycles[CKKS_PHASE_COUNT];
+                status = ecall_get_stats(global_eid, &ret, calls, cycles, CKKS_PHASE_COUNT);
+                if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                    std::cout << "  no phase breakdown: enclave built without STATS=1" << std::endl;
+                    continue;
+                }
+                uint64_t total = 0;
+                for (int p = 0; p < CKKS_PHASE_COUNT; p++) total += cycles[p];
+                std::cout << "phase,calls_per_op,kcycles_per_op,share" << std::endl;
+                for (int p = 0; p < CKKS_PHASE_COUNT; p++) {
+                    if (calls[p] == 0) continue;
+                    std::cout << phase_names[p] << "," << (double)calls[p] / iterations << ","
+                              << cycles[p] / 1000.0 / iterations << ","
+                              << 100.0 * cycles[p] / std::max(total, (uint64_t)1) << "%" << std::endl;
+                }
+            }
+        }
+        else if (mode == "encode") {
+            // Encrypting one message repeatedly: encoding on every ecall,
+            // then encoding once and encrypting the held plaintext; with
+            // --plaintext-cache, the first path also runs through the cache
+            uint32_t plaintext = 0;
+            status = ecall_encode(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(), slots,
+                                  &plaintext);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Encoding failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+
+            const char* path_names[2] = {plaintext_cache > 0 ? "encrypt (cached)" : "encrypt",
+                                         "encrypt-plaintext"};
+            for (int path = 0; path < 2; path++) {
+                std::vector<double> latencies;
+                for (int i = 0; i < iterations; i++) {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    if (path == 0) {
+                        status = ecall_encrypt(global_eid, &ret, global_context, msg_real.data(), msg_imag.data(),
+                                              slots, ciphertext.data(), ct_size);
+                    } else {
+                        status = ecall_encrypt_plaintext(global_eid, &ret, global_context, plaintext,
+                                                        ciphertext.data(), ct_size);
+                    }
+                    latencies.push_back(elapsed_ms(start));
+                    if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                        std::cerr << path_names[path] << " failed at iteration " << i << std::endl;
+                        sgx_destroy_enclave(global_eid);
+                        return -1;
+                    }
+                }
+
+                LatencySummary summary = summarize(latencies);
+                std::cout << path_names[path] << ": " << iterations << " ops, mean " << summary.mean << " ms, p50 "
+                          << summary.p50 << " ms, p99 " << summary.p99 << " ms" << std::endl;
+                samples.insert(samples.end(), latencies.begin(), latencies.end());
+            }
+
+            // The last ciphertext must still decrypt to the message
+            status = ecall_decrypt(global_eid, &ret, global_context, ciphertext.data(), ct_size,
+                                  result_real.data(), result_imag.data(), slots);
+            double max_error = 0.0;
+            for (int i = 0; i < slots; i++) {
+                max_error = std::max(max_error, std::fabs(result_real[i] - msg_real[i]));
+                max_error = std::max(max_error, std::fabs(result_imag[i] - msg_imag[i]));
+            }
+            ecall_release_plaintext(global_eid, &ret, global_context, plaintext);
+            if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+                std::cerr << "Decryption failed" << std::endl;
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+            std::cout << "Max error: " << max_error << std::endl;
+        }
+        else if (mode == "serve") {
+            // Keep the enclave, context and keys for every request until
+            // SIGINT/SIGTERM; one worker per concurrent ecall (--threads)
+            CKKSServerInfo info;
+            info.polyDegree = (uint32_t)polyDegree;
+            info.slots = (uint32_t)slots;
+            info.numModuli = (uint32_t)(depth + 1);
+            info.ctWords = ct_size;
+            if (runServer(global_eid, global_context, socket_path.c_str(), threads, info) != 0) {
+                sgx_destroy_enclave(global_eid);
+                return -1;
+            }
+        }
         else {
             std::cerr << "Unknown mode: " << mode << std::endl;
             sgx_destroy_enclave(global_eid);
             return -1;
         }
+
+        if (pool > 0) {
+            double seconds = elapsed_ms(pool_start) / 1000.0;
+            uint64_t hits = 0, misses = 0, refills = 0;
+            uint32_t ready = 0;
+            ecall_get_zero_pool_stats(global_eid, &ret, global_context, &hits, &misses, &refills, &ready);
+            stopRefill(global_eid, global_context);
+            std::cout << "Zero pool: " << pool << " deep, " << refillers << " refillers, " << hits << " hits, "
+                      << misses << " misses, " << refills << " refills (" << refills / seconds << "/sec), "
+                      << ready << " left" << std::endl;
+        }
+        if (plaintext_cache > 0) {
+            uint64_t hits = 0, misses = 0, evictions = 0;
+            uint32_t cached = 0;
+            ecall_get_plaintext_cache_stats(global_eid, &ret, global_context, &hits, &misses, &evictions, &cached);
+            std::cout << "Plaintext cache: " << plaintext_cache << " entries, " << hits << " hits, " << misses
+                      << " misses, " << evictions << " evictions, " << cached << " cached" << std::endl;
+        }
+    }
+
+    if (!samples_file.empty() && !write_samples(samples_file, samples)) {
+        std::cerr << "Cannot write " << samples_file << std::endl;
+        sgx_destroy_enclave(global_eid);
+        return -1;
     }
 
     // Cleanup
@@ -136,17 +846,21 @@ int main(int argc, char* argv[]) {
 void ocall_print_string(const char* str) { std::cout << str; }
 void ocall_print_int(int64_t value) { std::cout << value; }
 void ocall_print_double(double value) { std::cout << value; }
-void ocall_save_data(const uint8_t* data, size_t len, const char* filename) {
-    FILE* f = fopen(filename, "wb");
+size_t ocall_save_data(const uint8_t* data, size_t len, uint64_t offset, const char* filename) {
+    size_t bytes_written = 0;
+    FILE* f = fopen(filename, (offset == 0) ? "wb" : "r+b");
     if (f) {
-        fwrite(data, 1, len, f);
-        fclose(f);
+        if (fseeko(f, (off_t)offset, SEEK_SET) == 0) bytes_written = fwrite(data, 1, len, f);
+        if (fclose(f) != 0) bytes_written = 0;
     }
+    return bytes_written;
 }
-void ocall_load_data(uint8_t* data, size_t len, const char* filename) {
+size_t ocall_load_data(uint8_t* data, size_t len, uint64_t offset, const char* filename) {
+    size_t bytes_read = 0;
     FILE* f = fopen(filename, "rb");
     if (f) {
-        fread(data, 1, len, f);
+        if (fseeko(f, (off_t)offset, SEEK_SET) == 0) bytes_read = fread(data, 1, len, f);
         fclose(f);
     }
+    return bytes_read;
 }
@@ -0,0 +1,104 @@
+#include "AsyncRing.h"
+#include "Enclave_u.h"
+#include "CKKSRing.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <stdlib.h>
+#include <sched.h>
+
+// One request's buffers, reused once its completion has been reaped
+typedef struct {
+    std::vector<double> real;
+    std::vector<double> imag;
+    std::vector<int64_t> ciphertext;
+    std::chrono::steady_clock::time_point sent;
+} AsyncBuffer;
+
+double runAsync(sgx_enclave_id_t eid, uint32_t context, bool encrypting, int iterations, int workers, int inflight,
+                const std::vector<double>& msgReal, const std::vector<double>& msgImag,
+                const std::vector<int64_t>& ciphertext, std::vector<double>& latencies) {
+    if (iterations < 1 || workers < 1 || inflight < 1 || inflight > CKKS_RING_MAX_CAPACITY) return -1.0;
+    uint32_t capacity = 1;
+    while (capacity < (uint32_t)inflight) capacity *= 2;
+
+    void* memory = NULL;
+    if (posix_memalign(&memory, 64, CKKS_RING_BYTES(capacity)) != 0) return -1.0;
+    CKKSRingHeader* ring = (CKKSRingHeader*)memory;
+    ckksRingInit(ring, capacity);
+
+    sgx_status_t ret;
+    sgx_status_t status = ecall_register_ring(eid, &ret, ring, CKKS_RING_BYTES(capacity));
+    if (status != SGX_SUCCESS || ret != SGX_SUCCESS) {
+        free(memory);
+        return -1.0;
+    }
+
+    std::vector<AsyncBuffer> buffers(inflight);
+    std::vector<uint32_t> idle;
+    for (int b = inflight - 1; b >= 0; b--) {
+        buffers[b].real = encrypting ? msgReal : std::vector<double>(msgReal.size());
+        buffers[b].imag = encrypting ? msgImag : std::vector<double>(msgImag.size());
+        buffers[b].ciphertext = ciphertext;
+        idle.push_back((uint32_t)b);
+    }
+
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workers; t++) {
+        threads.push_back(std::thread([&]() {
+            sgx_status_t workerRet;
+            if (ecall_ring_worker(eid, &workerRet) != SGX_SUCCESS || workerRet != SGX_SUCCESS) failed = true;
+        }));
+    }
+
+    // Submit while a buffer is free, reap whatever has completed, and
+    // yield only when neither made progress
+    int submitted = 0;
+    int completed = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (completed < iterations && !failed) {
+        bool progress = false;
+        while (submitted < iterations && !idle.empty()) {
+            uint32_t b = idle.back();
+            CKKSRingRequest request;
+            request.tag = b;
+            request.op = encrypting ? CKKS_RING_OP_ENCRYPT : CKKS_RING_OP_DECRYPT;
+            request.msgLen = (uint32_t)buffers[b].real.size();
+            request.ctLen = (uint32_t)buffers[b].ciphertext.size();
+            request.context = context;
+            request.msgReal = (uint64_t)(uintptr_t)buffers[b].real.data();
+            request.msgImag = (uint64_t)(uintptr_t)buffers[b].imag.data();
+            request.ciphertext = (uint64_t)(uintptr_t)buffers[b].ciphertext.data();
+            buffers[b].sent = std::chrono::steady_clock::now();
+            if (!ckksRingSubmit(ring, capacity, &request)) break;
+            idle.pop_back();
+            submitted++;
+            progress = true;
+        }
+
+        CKKSRingCompletion completion;
+        while (ckksRingNextCompletion(ring, capacity, &completion)) {
+            if (completion.tag >= buffers.size() || completion.status != SGX_SUCCESS) failed = true;
+            if (failed) break;
+            latencies.push_back(elapsed_ms(buffers[completion.tag].sent));
+            idle.push_back((uint32_t)completion.tag);
+            completed++;
+            progress = true;
+        }
+        if (!progress) sched_yield();
+    }
+    double seconds = elapsed_ms(start) / 1000.0;
+
+    // Workers return once they see the flag; only then may the ring go
+    __atomic_store_n(&ring->stop, 1, __ATOMIC_RELEASE);
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    ecall_register_ring(eid, &ret, NULL, 0);
+    free(memory);
+    return failed ? -1.0 : iterations / seconds;
+}
+
+void ocall_ring_idle() { sched_yield(); }
@@ -0,0 +1,21 @@
+// AsyncRing.h - ckks_app's asynchronous mode over the enclave's request ring
+#ifndef _ASYNC_RING_H_
+#define _ASYNC_RING_H_
+
+#include "sgx_eid.h"
+#include <stdint.h>
+#include <vector>
+
+// Registers a CKKSRing.h ring with room for `inflight` requests, parks
+// `workers` threads in ecall_ring_worker and pushes `iterations`
+// encryptions (or decryptions of `ciphertext`) under `context` through it
+// from the calling thread, keeping up to `inflight` outstanding. Every request has
+// its own buffers, which the enclave reads and writes in place. Appends
+// each request's submit-to-completion latency in ms to `latencies` and
+// returns operations per second, or a negative value on failure. The
+// enclave needs `workers` free TCSs for the whole run.
+double runAsync(sgx_enclave_id_t eid, uint32_t context, bool encrypting, int iterations, int workers, int inflight,
+                const std::vector<double>& msgReal, const std::vector<double>& msgImag,
+                const std::vector<int64_t>& ciphertext, std::vector<double>& latencies);
+
+#endif // _ASYNC_RING_H_
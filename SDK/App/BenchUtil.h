@@ -0,0 +1,61 @@
+// BenchUtil.h - Command-line and latency helpers shared by ckks_app,
+// ckks_client and ckks_native
+#ifndef _BENCH_UTIL_H_
+#define _BENCH_UTIL_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Returns the value of an optional --name=value flag, or the fallback
+static inline std::string get_option(int argc, char* argv[], const std::string& name, const std::string& fallback) {
+    std::string prefix = "--" + name + "=";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, prefix.size(), prefix) == 0) return arg.substr(prefix.size());
+    }
+    return fallback;
+}
+
+// Milliseconds since `start`
+static inline double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Writes one per-operation latency in ms per line, for benchmark.py
+static inline bool write_samples(const std::string& path, const std::vector<double>& samples) {
+    std::ofstream out(path.c_str());
+    for (size_t i = 0; i < samples.size(); i++) out << samples[i] << "\n";
+    return (bool)out;
+}
+
+// Nearest-rank percentile of ascending samples
+static inline double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+typedef struct {
+    double mean;
+    double p50;
+    double p99;
+} LatencySummary;
+
+// Mean and nearest-rank p50/p99 of samples in any order; all zero if empty
+static inline LatencySummary summarize(const std::vector<double>& samples) {
+    LatencySummary summary = {0.0, 0.0, 0.0};
+    if (samples.empty()) return summary;
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); i++) summary.mean += sorted[i];
+    summary.mean /= (double)sorted.size();
+    summary.p50 = percentile(sorted, 0.50);
+    summary.p99 = percentile(sorted, 0.99);
+    return summary;
+}
+
+#endif // _BENCH_UTIL_H_
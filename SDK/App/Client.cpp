@@ -0,0 +1,133 @@
+// Client.cpp - Latency and throughput benchmark against `ckks_app serve`
+#include "ServerProtocol.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+// One request/response exchange; false on a transport error or a non-zero status
+bool call_server(int fd, uint32_t op, const void* payload, size_t len, std::vector<uint8_t>& response) {
+    CKKSFrameHeader header;
+    return sendFrame(fd, op, 0, payload, len) && recvFrame(fd, &header, response, (size_t)1 << 30) &&
+           header.op == op && header.status == 0;
+}
+
+// Issues `requests` requests over `connections` concurrent connections,
+// each sending its share back to back after `warmup` untimed ones. Fills
+// the per-request latencies in ms and returns requests per second, or a
+// negative value on failure.
+double run_connections(const std::string& socket_path, uint32_t op, int connections, int requests, int warmup,
+                       const std::vector<uint8_t>& payload, std::vector<double>& latencies) {
+    std::atomic<bool> failed(false);
+    std::vector<std::vector<double> > per_connection(connections);
+    std::vector<int> fds(connections, -1);
+    std::vector<uint8_t> response;
+    for (int c = 0; c < connections; c++) {
+        fds[c] = connectServer(socket_path.c_str());
+        if (fds[c] < 0) failed = true;
+        for (int i = 0; i < warmup && !failed; i++) {
+            if (!call_server(fds[c], op, payload.data(), payload.size(), response)) failed = true;
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int c = 0; c < connections && !failed; c++) {
+        int share = requests / connections + ((c < requests % connections) ? 1 : 0);
+        workers.push_back(std::thread([&, c, share]() {
+            std::vector<uint8_t> response;
+            for (int i = 0; i < share && !failed; i++) {
+                std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+                if (!call_server(fds[c], op, payload.data(), payload.size(), response)) failed = true;
+                per_connection[c].push_back(elapsed_ms(sent));
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (int c = 0; c < connections; c++) {
+        if (fds[c] >= 0) close(fds[c]);
+        latencies.insert(latencies.end(), per_connection[c].begin(), per_connection[c].end());
+    }
+    return failed ? -1.0 : requests / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).compare(0, 2, "--") != 0) args.push_back(argv[i]);
+    }
+
+    int iterations = (args.size() > 0) ? std::stoi(args[0]) : 1000;
+    std::string socket_path = get_option(argc, argv, "socket", CKKS_RPC_SOCKET);
+    std::string op_name = get_option(argc, argv, "op", "encrypt");
+    int connections = std::stoi(get_option(argc, argv, "connections", "1"));
+    int warmup = std::stoi(get_option(argc, argv, "warmup", "5"));
+
+    if (iterations < 1 || connections < 1 || warmup < 0 || (op_name != "encrypt" && op_name != "decrypt")) {
+        std::cerr << "Usage: " << argv[0] << " [iterations] [--socket=path] [--op=encrypt|decrypt]"
+                  << " [--connections=C] [--warmup=N]" << std::endl;
+        return -1;
+    }
+
+    int fd = connectServer(socket_path.c_str());
+    std::vector<uint8_t> response;
+    if (fd < 0 || !call_server(fd, CKKS_RPC_INFO, NULL, 0, response) || response.size() != sizeof(CKKSServerInfo)) {
+        std::cerr << "No ckks_app server on " << socket_path << std::endl;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    CKKSServerInfo info = *(const CKKSServerInfo*)(const void*)response.data();
+
+    // Same test message as ckks_app: reals, then imaginary parts
+    std::vector<double> message(2 * (size_t)info.slots);
+    for (uint32_t i = 0; i < info.slots; i++) {
+        message[i] = i * 1.1;
+        message[info.slots + i] = i * 0.5;
+    }
+    std::vector<uint8_t> encrypt_payload((const uint8_t*)message.data(),
+                                         (const uint8_t*)(message.data() + message.size()));
+
+    // A decrypt request carries a ciphertext; check its round trip once
+    std::vector<uint8_t> decrypt_payload;
+    if (!call_server(fd, CKKS_RPC_ENCRYPT, encrypt_payload.data(), encrypt_payload.size(), decrypt_payload) ||
+        !call_server(fd, CKKS_RPC_DECRYPT, decrypt_payload.data(), decrypt_payload.size(), response) ||
+        response.size() != message.size() * sizeof(double)) {
+        std::cerr << "Encrypt/decrypt round trip failed" << std::endl;
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    const double* decrypted = (const double*)(const void*)response.data();
+    double max_error = 0.0;
+    for (size_t i = 0; i < message.size(); i++) {
+        max_error = std::max(max_error, std::fabs(decrypted[i] - message[i]));
+    }
+    std::cout << "Server: N=" << info.polyDegree << ", " << info.numModuli << " moduli, "
+              << info.ctWords * sizeof(int64_t) << "-byte ciphertexts, round-trip error " << max_error << std::endl;
+
+    // Aggregate requests/sec and latency for 1, 2, 4, ... connections up to
+    // --connections; the server runs at most --threads of them at once
+    const bool encrypting = (op_name == "encrypt");
+    const uint32_t op = encrypting ? CKKS_RPC_ENCRYPT : CKKS_RPC_DECRYPT;
+    std::cout << "connections,requests_per_sec,mean_ms,p50_ms,p99_ms" << std::endl;
+    for (int c = 1; c <= connections; c = (c * 2 > connections && c < connections) ? connections : c * 2) {
+        std::vector<double> latencies;
+        double rate = run_connections(socket_path, op, c, iterations, warmup,
+                                      encrypting ? encrypt_payload : decrypt_payload, latencies);
+        if (rate < 0.0) {
+            std::cerr << "Benchmark failed with " << c << " connections" << std::endl;
+            return -1;
+        }
+        LatencySummary summary = summarize(latencies);
+        std::cout << c << "," << rate << "," << summary.mean << "," << summary.p50 << "," << summary.p99 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,390 @@
+#include "FileStream.h"
+#include "Enclave_u.h"
+#include "CKKSLayout.h"
+#include "WireFormat.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+// Files are read and written through buffers of this size
+#define STREAM_IO_BYTES (1 << 20)
+
+// One chunk's buffers, reused once the writer is done with it
+typedef struct {
+    uint64_t seq;
+    uint32_t count;
+    std::vector<double> real;
+    std::vector<double> imag;
+    std::vector<int64_t> ciphertext;
+} StreamChunk;
+
+// Hands chunks from one pipeline stage to the next
+class ChunkQueue {
+private:
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<StreamChunk*> chunks;
+    bool closed;
+
+public:
+    ChunkQueue() : closed(false) {}
+
+    void push(StreamChunk* chunk) {
+        std::lock_guard<std::mutex> guard(lock);
+        chunks.push_back(chunk);
+        changed.notify_one();
+    }
+
+    // Blocks until a chunk arrives; NULL once closed and drained
+    StreamChunk* pop() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (chunks.empty() && !closed) changed.wait(guard);
+        if (chunks.empty()) return NULL;
+        StreamChunk* chunk = chunks.front();
+        chunks.pop_front();
+        return chunk;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+};
+
+// Numbers separated by commas or whitespace, read a block at a time
+class CsvReader {
+private:
+    FILE* file;
+    std::vector<char> block;
+    size_t pos;
+    size_t end;
+    uint64_t total;
+
+public:
+    explicit CsvReader(FILE* f) : file(f), block(STREAM_IO_BYTES), pos(0), end(0), total(0) {}
+
+    // 1 with the next value, 0 at end of file, -1 on a malformed token
+    int next(double* value) {
+        char token[64];
+        size_t len = 0;
+        for (;;) {
+            if (pos == end) {
+                end = fread(block.data(), 1, block.size(), file);
+                pos = 0;
+                total += end;
+                if (end == 0) break;
+            }
+            char c = block[pos];
+            if (c == ',' || c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                pos++;
+                if (len > 0) break;
+                continue;
+            }
+            if (len + 1 == sizeof(token)) return -1;
+            token[len++] = c;
+            pos++;
+        }
+        if (ferror(file)) return -1;
+        if (len == 0) return 0;
+        token[len] = '\0';
+        char* parsed = NULL;
+        *value = strtod(token, &parsed);
+        return (*parsed == '\0') ? 1 : -1;
+    }
+
+    uint64_t bytes() const { return total; }
+};
+
+// Reads chunks on one thread, runs `process` on `workers` threads and
+// writes the results in input order on the calling thread. `read` returns
+// 1 for a chunk, 0 at end of input and -1 on an error. After a failure
+// the chunks in flight drain without being processed or written.
+static bool runPipeline(std::vector<StreamChunk>& chunks, int workers, const std::function<int(StreamChunk&)>& read,
+                        const std::function<bool(StreamChunk&)>& process,
+                        const std::function<bool(StreamChunk&)>& write) {
+    ChunkQueue idle, work, done;
+    for (size_t c = 0; c < chunks.size(); c++) idle.push(&chunks[c]);
+    std::atomic<bool> failed(false);
+    std::atomic<int> running(workers);
+
+    std::thread reader([&]() {
+        uint64_t seq = 0;
+        StreamChunk* chunk;
+        while (!failed && (chunk = idle.pop()) != NULL) {
+            int got = read(*chunk);
+            if (got <= 0) {
+                if (got < 0) failed = true;
+                break;
+            }
+            chunk->seq = seq++;
+            work.push(chunk);
+        }
+        work.close();
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workers; t++) {
+        threads.push_back(std::thread([&]() {
+            StreamChunk* chunk;
+            while ((chunk = work.pop()) != NULL) {
+                if (!failed && !process(*chunk)) failed = true;
+                done.push(chunk);
+            }
+            if (--running == 0) done.close();
+        }));
+    }
+
+    // Workers finish out of order; hold chunks until their turn comes
+    std::map<uint64_t, StreamChunk*> pending;
+    uint64_t next = 0;
+    StreamChunk* chunk;
+    while ((chunk = done.pop()) != NULL) {
+        pending[chunk->seq] = chunk;
+        for (std::map<uint64_t, StreamChunk*>::iterator it = pending.find(next); it != pending.end();
+             it = pending.find(next)) {
+            if (!failed && !write(*it->second)) failed = true;
+            idle.push(it->second);
+            pending.erase(it);
+            next++;
+        }
+    }
+
+    reader.join();
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    return !failed;
+}
+
+bool encryptFile(sgx_enclave_id_t eid, uint32_t context, const std::string& inPath, const std::string& outPath,
+                 int format, uint32_t polyDegree, uint32_t slots, uint32_t keepLimbs, int workers,
+                 StreamStats* stats) {
+    if (workers < 1 || slots == 0 || (format != CKKS_STREAM_BINARY && format != CKKS_STREAM_CSV)) return false;
+
+    uint64_t moduli[MAX_MODULI];
+    uint32_t numModuli = 0;
+    sgx_status_t ret;
+    sgx_status_t status = ecall_get_moduli(eid, &ret, context, moduli, MAX_MODULI, &numModuli);
+    if (status != SGX_SUCCESS || ret != SGX_SUCCESS) return false;
+
+    FILE* in = fopen(inPath.c_str(), "rb");
+    if (in == NULL) {
+        std::cerr << "Cannot open " << inPath << std::endl;
+        return false;
+    }
+    // The CSV reader does its own block reads
+    setvbuf(in, NULL, (format == CKKS_STREAM_BINARY) ? _IOFBF : _IONBF, STREAM_IO_BYTES);
+
+    std::vector<char> outBuffer(STREAM_IO_BYTES);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(outBuffer.data(), (std::streamsize)outBuffer.size());
+    out.open(outPath.c_str(), std::ios::binary);
+    CKKSStreamHeader header;
+    header.magic = CKKS_STREAM_MAGIC;
+    header.version = CKKS_STREAM_VERSION;
+    header.format = (uint16_t)format;
+    header.polyDegree = polyDegree;
+    header.slots = slots;
+    out.write((const char*)&header, sizeof(header));
+    if (!out) {
+        std::cerr << "Cannot write " << outPath << std::endl;
+        fclose(in);
+        return false;
+    }
+
+    const uint32_t ctWords = (uint32_t)CKKS_CT_WORDS(polyDegree, numModuli);
+    std::vector<StreamChunk> chunks(2 * (size_t)workers + 2);
+    for (size_t c = 0; c < chunks.size(); c++) {
+        chunks[c].real.resize(slots);
+        chunks[c].imag.resize(slots);
+        chunks[c].ciphertext.resize(ctWords);
+    }
+
+    CsvReader csv(in);
+    uint64_t values = 0;
+    uint64_t written = 0;
+    std::function<int(StreamChunk&)> read = [&](StreamChunk& chunk) -> int {
+        uint32_t count = 0;
+        if (format == CKKS_STREAM_BINARY) {
+            size_t got = fread(chunk.real.data(), sizeof(double), slots, in);
+            if (got == slots) got += fread(chunk.imag.data(), sizeof(double), slots, in);
+            count = (uint32_t)got;
+            // A short read must end exactly on a value boundary
+            if (ferror(in) || (count < 2 * slots && ftell(in) != (long)((values + count) * sizeof(double)))) {
+                std::cerr << inPath << " is not a whole number of doubles" << std::endl;
+                return -1;
+            }
+        } else {
+            double value = 0.0;
+            while (count < 2 * slots) {
+                int got = csv.next(&value);
+                if (got < 0) {
+                    std::cerr << "Malformed number after value " << values + count << " in " << inPath << std::endl;
+                    return -1;
+                }
+                if (got == 0) break;
+                if (count < slots) {
+                    chunk.real[count] = value;
+                } else {
+                    chunk.imag[count - slots] = value;
+                }
+                count++;
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            if (!std::isfinite((i < slots) ? chunk.real[i] : chunk.imag[i - slots])) {
+                std::cerr << "Value " << values + i << " in " << inPath << " is not finite" << std::endl;
+                return -1;
+            }
+        }
+        // The rest of a short last chunk encrypts zeros
+        for (uint32_t i = count; i < 2 * slots; i++) {
+            if (i < slots) {
+                chunk.real[i] = 0.0;
+            } else {
+                chunk.imag[i - slots] = 0.0;
+            }
+        }
+        chunk.count = count;
+        values += count;
+        return (count > 0) ? 1 : 0;
+    };
+    std::function<bool(StreamChunk&)> process = [&](StreamChunk& chunk) -> bool {
+        sgx_status_t workerRet;
+        sgx_status_t workerStatus = ecall_encrypt(eid, &workerRet, context, chunk.real.data(), chunk.imag.data(),
+                                                  slots, chunk.ciphertext.data(), ctWords);
+        if (workerStatus != SGX_SUCCESS || workerRet != SGX_SUCCESS) {
+            std::cerr << "Encryption failed at chunk " << chunk.seq << std::endl;
+            return false;
+        }
+        return true;
+    };
+    std::function<bool(StreamChunk&)> write = [&](StreamChunk& chunk) -> bool {
+        out.write((const char*)&chunk.count, sizeof(chunk.count));
+        if (!writeWireCiphertext(out, chunk.ciphertext.data(), polyDegree, moduli, keepLimbs)) {
+            std::cerr << "Cannot write " << outPath << std::endl;
+            return false;
+        }
+        written++;
+        return true;
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = runPipeline(chunks, workers, read, process, write);
+    out.flush();
+    ok = ok && (bool)out;
+    stats->seconds = elapsed_ms(start) / 1000.0;
+    stats->values = values;
+    stats->chunks = written;
+    stats->plainBytes = (format == CKKS_STREAM_BINARY) ? values * sizeof(double) : csv.bytes();
+    stats->cipherBytes = ok ? (uint64_t)out.tellp() : 0;
+    fclose(in);
+    return ok;
+}
+
+bool decryptFile(sgx_enclave_id_t eid, uint32_t context, const std::string& inPath, const std::string& outPath,
+                 int format, uint32_t polyDegree, uint32_t slots, int workers, StreamStats* stats) {
+    if (workers < 1 || slots == 0 || format > CKKS_STREAM_CSV) return false;
+
+    std::vector<char> inBuffer(STREAM_IO_BYTES);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(inBuffer.data(), (std::streamsize)inBuffer.size());
+    in.open(inPath.c_str(), std::ios::binary);
+    CKKSStreamHeader header;
+    in.read((char*)&header, sizeof(header));
+    if (!in || header.magic != CKKS_STREAM_MAGIC || header.version != CKKS_STREAM_VERSION ||
+        header.format > CKKS_STREAM_CSV) {
+        std::cerr << inPath << " is not a stream file" << std::endl;
+        return false;
+    }
+    if (header.polyDegree != polyDegree || header.slots != slots) {
+        std::cerr << inPath << " was written with N=" << header.polyDegree << " and " << header.slots
+                  << " slots; run with those parameters" << std::endl;
+        return false;
+    }
+    if (format < 0) format = header.format;
+
+    FILE* out = fopen(outPath.c_str(), "wb");
+    if (out == NULL) {
+        std::cerr << "Cannot open " << outPath << std::endl;
+        return false;
+    }
+    setvbuf(out, NULL, _IOFBF, STREAM_IO_BYTES);
+
+    std::vector<StreamChunk> chunks(2 * (size_t)workers + 2);
+    for (size_t c = 0; c < chunks.size(); c++) {
+        chunks[c].real.resize(slots);
+        chunks[c].imag.resize(slots);
+    }
+
+    uint64_t records = 0;
+    uint64_t values = 0;
+    uint64_t written = 0;
+    std::function<int(StreamChunk&)> read = [&](StreamChunk& chunk) -> int {
+        if (in.peek() == std::char_traits<char>::eof()) return in.bad() ? -1 : 0;
+        uint32_t count = 0;
+        uint32_t degree = 0;
+        in.read((char*)&count, sizeof(count));
+        if (!in || count == 0 || count > 2 * slots || !readWireCiphertext(in, chunk.ciphertext, &degree) ||
+            degree != polyDegree) {
+            std::cerr << "Malformed chunk " << records << " in " << inPath << std::endl;
+            return -1;
+        }
+        chunk.count = count;
+        records++;
+        return 1;
+    };
+    std::function<bool(StreamChunk&)> process = [&](StreamChunk& chunk) -> bool {
+        sgx_status_t workerRet;
+        sgx_status_t workerStatus = ecall_decrypt(eid, &workerRet, context, chunk.ciphertext.data(),
+                                                  (uint32_t)chunk.ciphertext.size(), chunk.real.data(),
+                                                  chunk.imag.data(), slots);
+        if (workerStatus != SGX_SUCCESS || workerRet != SGX_SUCCESS) {
+            std::cerr << "Decryption failed at chunk " << chunk.seq << std::endl;
+            return false;
+        }
+        return true;
+    };
+    std::function<bool(StreamChunk&)> write = [&](StreamChunk& chunk) -> bool {
+        const uint32_t realCount = (chunk.count < slots) ? chunk.count : slots;
+        if (format == CKKS_STREAM_BINARY) {
+            fwrite(chunk.real.data(), sizeof(double), realCount, out);
+            fwrite(chunk.imag.data(), sizeof(double), chunk.count - realCount, out);
+        } else {
+            for (uint32_t i = 0; i < chunk.count; i++) {
+                fprintf(out, "%.17g\n", (i < slots) ? chunk.real[i] : chunk.imag[i - slots]);
+            }
+        }
+        if (ferror(out)) {
+            std::cerr << "Cannot write " << outPath << std::endl;
+            return false;
+        }
+        values += chunk.count;
+        written++;
+        return true;
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool ok = runPipeline(chunks, workers, read, process, write);
+    ok = (fflush(out) == 0) && ok;
+    stats->seconds = elapsed_ms(start) / 1000.0;
+    stats->values = values;
+    stats->chunks = written;
+    stats->plainBytes = (uint64_t)ftell(out);
+    struct stat st;
+    stats->cipherBytes = (stat(inPath.c_str(), &st) == 0) ? (uint64_t)st.st_size : 0;
+    ok = (fclose(out) == 0) && ok;
+    return ok;
+}
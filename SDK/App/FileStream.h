@@ -0,0 +1,57 @@
+// FileStream.h - ckks_app's streaming file encryption and decryption
+#ifndef _FILE_STREAM_H_
+#define _FILE_STREAM_H_
+
+#include "sgx_eid.h"
+#include <stdint.h>
+#include <string>
+
+// A stream file is this header followed by one record per chunk: a
+// uint32_t count of values (1 to 2 * slots) and then the chunk as one
+// WireFormat.h ciphertext. Each chunk carries up to `slots` values in the
+// real parts of the slots and the next `slots` in the imaginary parts.
+#define CKKS_STREAM_MAGIC 0x53464b43   // "CKFS"
+#define CKKS_STREAM_VERSION 1
+
+// Plaintext layouts: raw little-endian doubles, or decimal numbers
+// separated by commas or whitespace
+#define CKKS_STREAM_BINARY 0
+#define CKKS_STREAM_CSV 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t format;        // layout the plaintext was read in
+    uint32_t polyDegree;
+    uint32_t slots;
+} CKKSStreamHeader;
+
+typedef struct {
+    uint64_t values;
+    uint64_t chunks;
+    uint64_t plainBytes;
+    uint64_t cipherBytes;
+    double seconds;
+} StreamStats;
+
+// Both directions run as a pipeline: one thread reads chunks, `workers`
+// threads pass them through the enclave under `context`, and the calling
+// thread writes them in input order. A fixed set of 2 * workers + 2 chunk
+// buffers circulates between the stages, so memory use does not depend
+// on the file size. Returns false, with a message on stderr, on malformed
+// input, an I/O error or a failed ecall.
+
+// Encrypts the `format` plaintext at inPath into a stream file at
+// outPath, keeping `keepLimbs` RNS limbs of each ciphertext (0 keeps all).
+// `slots` must be the slots the context was created with.
+bool encryptFile(sgx_enclave_id_t eid, uint32_t context, const std::string& inPath, const std::string& outPath,
+                 int format, uint32_t polyDegree, uint32_t slots, uint32_t keepLimbs, int workers,
+                 StreamStats* stats);
+
+// Decrypts a stream file back into plaintext. A negative `format` writes
+// the layout recorded in the file. The file must have been written with
+// the context's degree and slots.
+bool decryptFile(sgx_enclave_id_t eid, uint32_t context, const std::string& inPath, const std::string& outPath,
+                 int format, uint32_t polyDegree, uint32_t slots, int workers, StreamStats* stats);
+
+#endif // _FILE_STREAM_H_
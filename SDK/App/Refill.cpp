@@ -0,0 +1,52 @@
+#include "Refill.h"
+#include "Enclave_u.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Workers are detached so that an error exit cannot leave joinable
+// threads behind; stopRefill waits for this count instead
+static std::atomic<int> g_refillers(0);
+
+// Full pools are polled for at most this long
+#define REFILL_FILL_TIMEOUT_MS 60000
+
+bool startRefill(sgx_enclave_id_t eid, uint32_t context, uint32_t depth, int refillers) {
+    sgx_status_t ret;
+    sgx_status_t status = ecall_configure_zero_pool(eid, &ret, context, depth);
+    if (status != SGX_SUCCESS || ret != SGX_SUCCESS || refillers < 1) return false;
+
+    for (int t = 0; t < refillers; t++) {
+        g_refillers++;
+        std::thread([eid, context]() {
+            sgx_status_t workerRet;
+            ecall_zero_pool_worker(eid, &workerRet, context);
+            g_refillers--;
+        }).detach();
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (;;) {
+        uint64_t hits = 0, misses = 0, refills = 0;
+        uint32_t ready = 0;
+        status = ecall_get_zero_pool_stats(eid, &ret, context, &hits, &misses, &refills, &ready);
+        if (status != SGX_SUCCESS || ret != SGX_SUCCESS) break;
+        if (ready >= depth) {
+            ecall_reset_zero_pool_stats(eid, &ret, context);
+            return true;
+        }
+        if (g_refillers == 0 || std::chrono::steady_clock::now() - start >
+                                    std::chrono::milliseconds(REFILL_FILL_TIMEOUT_MS)) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stopRefill(eid, context);
+    return false;
+}
+
+void stopRefill(sgx_enclave_id_t eid, uint32_t context) {
+    sgx_status_t ret;
+    ecall_configure_zero_pool(eid, &ret, context, 0);
+    while (g_refillers > 0) std::this_thread::yield();
+}
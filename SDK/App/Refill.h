@@ -0,0 +1,18 @@
+// Refill.h - Host threads behind the enclave's encryption-of-zero pool
+#ifndef _REFILL_H_
+#define _REFILL_H_
+
+#include "sgx_eid.h"
+#include <stdint.h>
+
+// Sizes the pool of `context` to `depth` entries and parks `refillers` threads in
+// ecall_zero_pool_worker to keep it full, then waits until it is full so
+// that timed runs start warm. Needs a context with keys, and `refillers`
+// free TCSs for as long as the pool runs. Returns false if the pool
+// cannot be configured or does not fill.
+bool startRefill(sgx_enclave_id_t eid, uint32_t context, uint32_t depth, int refillers);
+
+// Disables the pool and returns once its workers have left the enclave
+void stopRefill(sgx_enclave_id_t eid, uint32_t context);
+
+#endif // _REFILL_H_
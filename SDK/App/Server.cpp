@@ -0,0 +1,164 @@
+#include "Server.h"
+#include "Enclave_u.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static volatile sig_atomic_t g_stopping = 0;
+static int g_listenFd = -1;
+// Connection each worker is serving, -1 while it waits in accept
+static volatile int* g_connectionFds = NULL;
+static int g_workers = 0;
+
+// Shutting the sockets down wakes every worker blocked in accept or in
+// the middle of reading a request
+static void onStopSignal(int) {
+    g_stopping = 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (g_listenFd >= 0) shutdown(g_listenFd, SHUT_RDWR);
+    for (int t = 0; t < g_workers; t++) {
+        if (g_connectionFds[t] >= 0) shutdown(g_connectionFds[t], SHUT_RDWR);
+    }
+}
+
+static int listenOn(const char* path, int backlog) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    // A socket file left by a previous run would make bind fail
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || chmod(path, S_IRUSR | S_IWUSR) != 0 ||
+        listen(fd, backlog) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Answers requests on one connection until the client closes it or sends
+// a malformed frame. Buffers are kept across requests.
+static void serveConnection(sgx_enclave_id_t eid, uint32_t context, int fd, const CKKSServerInfo& info,
+                            std::atomic<uint64_t>& served) {
+    const size_t ctBytes = (size_t)info.ctWords * sizeof(int64_t);
+    const size_t msgBytes = 2 * (size_t)info.slots * sizeof(double);
+    CKKSFrameHeader request;
+    std::vector<uint8_t> payload;
+    std::vector<int64_t> ciphertext(info.ctWords);
+    std::vector<double> message(2 * (size_t)info.slots);
+
+    while (!g_stopping && recvFrame(fd, &request, payload, (ctBytes > msgBytes) ? ctBytes : msgBytes)) {
+        sgx_status_t ret = SGX_ERROR_INVALID_PARAMETER;
+        sgx_status_t status = SGX_SUCCESS;
+        const void* response = NULL;
+        size_t responseBytes = 0;
+
+        if (request.op == CKKS_RPC_INFO) {
+            ret = SGX_SUCCESS;
+            response = &info;
+            responseBytes = sizeof(info);
+        } else if (request.op == CKKS_RPC_ENCRYPT) {
+            const uint32_t msgLen = (uint32_t)(payload.size() / (2 * sizeof(double)));
+            if (msgLen > 0 && payload.size() == msgLen * 2 * sizeof(double)) {
+                const double* msgReal = (const double*)(const void*)payload.data();
+                status = ecall_encrypt(eid, &ret, context, msgReal, msgReal + msgLen, msgLen,
+                                       ciphertext.data(), info.ctWords);
+                response = ciphertext.data();
+                responseBytes = ctBytes;
+            }
+        } else if (request.op == CKKS_RPC_DECRYPT) {
+            const uint32_t ctLen = (uint32_t)(payload.size() / sizeof(int64_t));
+            if (ctLen > 0 && payload.size() == ctLen * sizeof(int64_t)) {
+                status = ecall_decrypt(eid, &ret, context, (const int64_t*)(const void*)payload.data(), ctLen,
+                                       message.data(), message.data() + info.slots, info.slots);
+                response = message.data();
+                responseBytes = msgBytes;
+            }
+        }
+
+        if (status != SGX_SUCCESS) ret = status;
+        if (ret != SGX_SUCCESS) responseBytes = 0;
+        if (!sendFrame(fd, request.op, (uint32_t)ret, response, responseBytes)) break;
+        served++;
+    }
+}
+
+int runServer(sgx_enclave_id_t eid, uint32_t context, const char* path, int threads, const CKKSServerInfo& info) {
+    g_listenFd = listenOn(path, 4 * threads);
+    if (g_listenFd < 0) {
+        std::cerr << "Cannot listen on " << path << std::endl;
+        return -1;
+    }
+
+    std::vector<int> connectionFds(threads, -1);
+    g_connectionFds = connectionFds.data();
+    g_workers = threads;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    std::cout << "Serving on " << path << " with " << threads << " workers" << std::endl;
+
+    // Each worker accepts on the shared socket, so at most `threads`
+    // ecalls are in flight; size it to the enclave's TCS count
+    std::atomic<uint64_t> served(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            while (!g_stopping) {
+                int fd = accept(g_listenFd, NULL, NULL);
+                if (fd < 0) {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+                    // Out of descriptors or buffers: wait for connections
+                    // to close instead of spinning
+                    if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                        usleep(10000);
+                        continue;
+                    }
+                    // The stop signal shuts the socket down; anything else is fatal too
+                    if (!g_stopping) std::cerr << "accept: " << strerror(errno) << std::endl;
+                    break;
+                }
+                g_connectionFds[t] = fd;
+                // A stop signal that came before the store above did not see fd
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (g_stopping) {
+                    g_connectionFds[t] = -1;
+                    close(fd);
+                    break;
+                }
+                serveConnection(eid, context, fd, info, served);
+                g_connectionFds[t] = -1;
+                close(fd);
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    g_workers = 0;
+    g_connectionFds = NULL;
+
+    close(g_listenFd);
+    g_listenFd = -1;
+    unlink(path);
+    std::cout << "Served " << served.load() << " requests" << std::endl;
+    return 0;
+}
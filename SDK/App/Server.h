@@ -0,0 +1,17 @@
+// Server.h - Long-lived ckks_app mode serving requests over a UNIX socket
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include "sgx_eid.h"
+#include "ServerProtocol.h"
+
+// Serves CKKS_RPC_* requests on a UNIX-domain stream socket at `path`
+// with `context`, whose keys are already loaded, so enclave
+// creation, ecall_init_ckks and key loading are paid once for all
+// requests. `threads` workers each serve one connection at a time and
+// issue their ecalls concurrently; further connections wait in the
+// listen queue. Returns 0 after SIGINT or SIGTERM, -1 if the socket
+// cannot be set up.
+int runServer(sgx_enclave_id_t eid, uint32_t context, const char* path, int threads, const CKKSServerInfo& info);
+
+#endif // _SERVER_H_
@@ -0,0 +1,64 @@
+#include "ServerProtocol.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+bool sendAll(int fd, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        // A vanished client must not kill the server with SIGPIPE
+        ssize_t sent = send(fd, p, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        p += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+bool recvAll(int fd, void* data, size_t len) {
+    uint8_t* p = (uint8_t*)data;
+    while (len > 0) {
+        ssize_t got = recv(fd, p, len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        p += got;
+        len -= (size_t)got;
+    }
+    return true;
+}
+
+bool sendFrame(int fd, uint32_t op, uint32_t status, const void* payload, size_t len) {
+    CKKSFrameHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CKKS_RPC_MAGIC;
+    header.op = op;
+    header.status = status;
+    header.length = len;
+    return sendAll(fd, &header, sizeof(header)) && (len == 0 || sendAll(fd, payload, len));
+}
+
+bool recvFrame(int fd, CKKSFrameHeader* header, std::vector<uint8_t>& payload, size_t maxPayload) {
+    if (!recvAll(fd, header, sizeof(*header))) return false;
+    if (header->magic != CKKS_RPC_MAGIC || header->length > maxPayload) return false;
+    payload.resize((size_t)header->length);
+    return header->length == 0 || recvAll(fd, payload.data(), payload.size());
+}
+
+int connectServer(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,58 @@
+// ServerProtocol.h - Framed request/response protocol of the ckks_app server
+#ifndef _SERVER_PROTOCOL_H_
+#define _SERVER_PROTOCOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Every request and response is a CKKSFrameHeader followed by `length`
+// payload bytes. A connection carries any number of requests, each
+// answered in order before the next is read. Payloads are host-endian;
+// client and server share the machine.
+//
+//   op             request payload                  response payload
+//   CKKS_RPC_INFO  none                             CKKSServerInfo
+//   ENCRYPT        msg_len reals, then msg_len      ciphertext (CKKSLayout.h)
+//                  imaginary parts (doubles)
+//   DECRYPT        ciphertext, either layout        slots reals, then slots
+//                                                   imaginary parts
+//
+// A response with a status other than SGX_SUCCESS (0) has no payload.
+#define CKKS_RPC_MAGIC 0x43505243      // "CRPC"
+
+#define CKKS_RPC_INFO 1
+#define CKKS_RPC_ENCRYPT 2
+#define CKKS_RPC_DECRYPT 3
+
+// Default socket path, relative to the server's working directory
+#define CKKS_RPC_SOCKET "ckks.sock"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t op;            // CKKS_RPC_*; echoed in the response
+    uint32_t status;        // sgx_status_t of the response, 0 in requests
+    uint32_t reserved;
+    uint64_t length;        // payload bytes
+} CKKSFrameHeader;
+
+typedef struct {
+    uint32_t polyDegree;
+    uint32_t slots;
+    uint32_t numModuli;     // limbs of a fresh ciphertext
+    uint32_t ctWords;       // int64 words of a fresh ciphertext
+} CKKSServerInfo;
+
+// Blocking socket I/O; false on error or when the peer closes the connection
+bool sendAll(int fd, const void* data, size_t len);
+bool recvAll(int fd, void* data, size_t len);
+
+// Sends a header and its payload
+bool sendFrame(int fd, uint32_t op, uint32_t status, const void* payload, size_t len);
+// Receives a frame whose payload does not exceed maxPayload bytes
+bool recvFrame(int fd, CKKSFrameHeader* header, std::vector<uint8_t>& payload, size_t maxPayload);
+
+// Connects to the server's socket; returns the descriptor or -1
+int connectServer(const char* path);
+
+#endif // _SERVER_PROTOCOL_H_
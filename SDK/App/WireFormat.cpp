@@ -0,0 +1,233 @@
+#include "WireFormat.h"
+#include <string.h>
+
+uint32_t wireLimbBits(uint64_t q) {
+    uint32_t bits = 0;
+    while (bits < 64 && (q - 1) >> bits) bits++;
+    return bits;
+}
+
+size_t wireSize(const CKKSWireHeader& header) {
+    size_t bytes = sizeof(CKKSWireHeader);
+    size_t limbs = 0;
+    for (uint32_t j = 0; j < header.numModuli; j++) {
+        limbs += ((size_t)header.polyDegree * header.limbBits[j] + 7) / 8;
+    }
+    bytes += limbs;
+    bytes += (header.flags & CKKS_CT_FLAG_SEEDED) ? CKKS_CT_SEED_BYTES : limbs;
+    return bytes;
+}
+
+// The header is written as laid out in memory; every SGX host is little-endian
+static bool validHeader(const CKKSWireHeader& header) {
+    if (header.magic != CKKS_WIRE_MAGIC || header.version != CKKS_WIRE_VERSION) return false;
+    if ((header.flags & ~CKKS_CT_FLAG_SEEDED) != 0) return false;
+    if (header.polyDegree == 0 || header.polyDegree > MAX_POLY_DEGREE) return false;
+    if (header.numModuli == 0 || header.numModuli > MAX_MODULI) return false;
+    for (uint32_t j = 0; j < header.numModuli; j++) {
+        if (header.limbBits[j] == 0 || header.limbBits[j] > 63) return false;
+    }
+    return true;
+}
+
+WireEncoder::WireEncoder(std::ostream& stream) : out(stream), used(0), acc(0), accBits(0) {
+}
+
+bool WireEncoder::flush() {
+    if (used > 0) out.write((const char*)buffer, (std::streamsize)used);
+    used = 0;
+    return (bool)out;
+}
+
+void WireEncoder::putBits(uint64_t value, uint32_t bits) {
+    // accBits stays below 8 between calls, so split values that would
+    // overflow the 64-bit accumulator
+    if (bits > 56) {
+        putBits(value & 0xFFFFFFFF, 32);
+        value >>= 32;
+        bits -= 32;
+    }
+    acc |= value << accBits;
+    accBits += bits;
+    while (accBits >= 8) {
+        if (used == sizeof(buffer)) flush();
+        buffer[used++] = (uint8_t)acc;
+        acc >>= 8;
+        accBits -= 8;
+    }
+}
+
+void WireEncoder::alignByte() {
+    if (accBits > 0) putBits(0, 8 - accBits);
+}
+
+bool WireEncoder::putHeader(const CKKSWireHeader& header) {
+    if (!validHeader(header)) return false;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        putBits(((const uint8_t*)&header)[i], 8);
+    }
+    return true;
+}
+
+bool WireEncoder::putLimb(const uint64_t* residues, uint32_t n, uint32_t bits) {
+    const uint64_t limit = (bits >= 64) ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+    for (uint32_t i = 0; i < n; i++) {
+        if (residues[i] > limit) return false;
+        putBits(residues[i], bits);
+    }
+    alignByte();
+    return true;
+}
+
+bool WireEncoder::putSeed(const uint8_t* seed) {
+    for (uint32_t i = 0; i < CKKS_CT_SEED_BYTES; i++) {
+        putBits(seed[i], 8);
+    }
+    return true;
+}
+
+bool WireEncoder::finish() {
+    alignByte();
+    return flush();
+}
+
+WireDecoder::WireDecoder(std::istream& stream)
+    : in(stream), used(0), available(0), remaining(0), acc(0), accBits(0) {
+}
+
+bool WireDecoder::getByte(uint8_t* byte) {
+    if (used == available) {
+        size_t chunk = (remaining < sizeof(buffer)) ? remaining : sizeof(buffer);
+        if (chunk == 0) return false;
+        in.read((char*)buffer, (std::streamsize)chunk);
+        available = (size_t)in.gcount();
+        remaining -= available;
+        used = 0;
+        if (available == 0) return false;
+    }
+    *byte = buffer[used++];
+    return true;
+}
+
+bool WireDecoder::getBits(uint64_t* value, uint32_t bits) {
+    uint64_t result = 0;
+    uint32_t filled = 0;
+    while (filled < bits) {
+        if (accBits == 0) {
+            uint8_t byte;
+            if (!getByte(&byte)) return false;
+            acc = byte;
+            accBits = 8;
+        }
+        uint32_t take = (bits - filled < accBits) ? bits - filled : accBits;
+        result |= (acc & (((uint64_t)1 << take) - 1)) << filled;
+        acc >>= take;
+        accBits -= take;
+        filled += take;
+    }
+    *value = result;
+    return true;
+}
+
+bool WireDecoder::getHeader(CKKSWireHeader* header) {
+    used = 0;
+    available = 0;
+    remaining = sizeof(*header);
+    acc = 0;
+    accBits = 0;
+    for (size_t i = 0; i < sizeof(*header); i++) {
+        uint8_t byte;
+        if (!getByte(&byte)) return false;
+        ((uint8_t*)header)[i] = byte;
+    }
+    if (!validHeader(*header)) return false;
+
+    remaining = wireSize(*header) - sizeof(*header);
+    return true;
+}
+
+bool WireDecoder::getLimb(uint64_t* residues, uint32_t n, uint32_t bits) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (!getBits(&residues[i], bits)) return false;
+    }
+    acc = 0;
+    accBits = 0;
+    return true;
+}
+
+bool WireDecoder::getSeed(uint8_t* seed) {
+    for (uint32_t i = 0; i < CKKS_CT_SEED_BYTES; i++) {
+        if (!getByte(&seed[i])) return false;
+    }
+    return true;
+}
+
+bool writeWireCiphertext(std::ostream& out, const int64_t* ciphertext, uint32_t polyDegree,
+                         const uint64_t* moduli, uint32_t keepLimbs) {
+    CKKSCiphertextHeader ct;
+    memcpy(&ct, ciphertext, sizeof(ct));
+    if (ct.numModuli == 0 || ct.numModuli > MAX_MODULI) return false;
+    const bool seeded = (ct.flags & CKKS_CT_FLAG_SEEDED) != 0;
+
+    CKKSWireHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CKKS_WIRE_MAGIC;
+    header.version = CKKS_WIRE_VERSION;
+    header.flags = (uint16_t)ct.flags;
+    header.polyDegree = polyDegree;
+    header.numModuli = (keepLimbs == 0 || keepLimbs > ct.numModuli) ? ct.numModuli : keepLimbs;
+    header.scale = ct.scale;
+    for (uint32_t j = 0; j < header.numModuli; j++) {
+        header.limbBits[j] = (uint8_t)wireLimbBits(moduli[j]);
+    }
+
+    // Dropped limbs are simply skipped: limb j of c1 (or the seed) sits
+    // after all ct.numModuli limbs of c0 in the buffer
+    WireEncoder encoder(out);
+    if (!encoder.putHeader(header)) return false;
+    const uint64_t* c0 = (const uint64_t*)(ciphertext + CKKS_CT_HEADER_WORDS);
+    const uint64_t* c1 = c0 + (size_t)ct.numModuli * polyDegree;
+    for (uint32_t j = 0; j < header.numModuli; j++) {
+        if (!encoder.putLimb(c0 + (size_t)j * polyDegree, polyDegree, header.limbBits[j])) return false;
+    }
+    if (seeded) {
+        encoder.putSeed((const uint8_t*)c1);
+    } else {
+        for (uint32_t j = 0; j < header.numModuli; j++) {
+            if (!encoder.putLimb(c1 + (size_t)j * polyDegree, polyDegree, header.limbBits[j])) return false;
+        }
+    }
+    return encoder.finish();
+}
+
+bool readWireCiphertext(std::istream& in, std::vector<int64_t>& ciphertext, uint32_t* polyDegree) {
+    WireDecoder decoder(in);
+    CKKSWireHeader header;
+    if (!decoder.getHeader(&header)) return false;
+
+    const uint32_t n = header.polyDegree;
+    const bool seeded = (header.flags & CKKS_CT_FLAG_SEEDED) != 0;
+    ciphertext.assign(seeded ? CKKS_CT_SEEDED_WORDS(n, header.numModuli) : CKKS_CT_WORDS(n, header.numModuli), 0);
+
+    CKKSCiphertextHeader ct;
+    ct.numModuli = header.numModuli;
+    ct.flags = header.flags;
+    ct.scale = header.scale;
+    memcpy(ciphertext.data(), &ct, sizeof(ct));
+
+    uint64_t* c0 = (uint64_t*)(ciphertext.data() + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + (size_t)header.numModuli * n;
+    for (uint32_t j = 0; j < header.numModuli; j++) {
+        if (!decoder.getLimb(c0 + (size_t)j * n, n, header.limbBits[j])) return false;
+    }
+    if (seeded) {
+        if (!decoder.getSeed((uint8_t*)c1)) return false;
+    } else {
+        for (uint32_t j = 0; j < header.numModuli; j++) {
+            if (!decoder.getLimb(c1 + (size_t)j * n, n, header.limbBits[j])) return false;
+        }
+    }
+
+    *polyDegree = n;
+    return true;
+}
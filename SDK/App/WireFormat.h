@@ -0,0 +1,94 @@
+// WireFormat.h - Compact, self-describing ciphertext format for storage and transfer
+#ifndef _WIRE_FORMAT_H_
+#define _WIRE_FORMAT_H_
+
+#include "CKKSLayout.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <iostream>
+#include <vector>
+
+// A wire ciphertext is a fixed header followed by the residues of every
+// limb bit-packed at that limb's modulus width (LSB first, each limb padded
+// to a whole byte), c0 limbs first and then either the c1 limbs or, for
+// seeded ciphertexts, the raw 32-byte seed.
+#define CKKS_WIRE_MAGIC 0x46574b43     // "CKWF"
+#define CKKS_WIRE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;                 // CKKS_CT_FLAG_* of the ciphertext
+    uint32_t polyDegree;
+    uint32_t numModuli;             // limbs per component actually stored
+    double scale;
+    uint8_t limbBits[MAX_MODULI];   // ceil(log2(q_j)) for each stored limb
+} CKKSWireHeader;
+
+// Bits needed for residues modulo q
+uint32_t wireLimbBits(uint64_t q);
+
+// Number of bytes a ciphertext occupies on the wire
+size_t wireSize(const CKKSWireHeader& header);
+
+// Streams one ciphertext out limb by limb through a small staging buffer,
+// so nothing the size of a whole ciphertext is held besides the input.
+class WireEncoder {
+private:
+    std::ostream& out;
+    uint8_t buffer[4096];
+    size_t used;
+    uint64_t acc;
+    uint32_t accBits;
+
+    void putBits(uint64_t value, uint32_t bits);
+    void alignByte();
+    bool flush();
+
+public:
+    explicit WireEncoder(std::ostream& stream);
+
+    bool putHeader(const CKKSWireHeader& header);
+    // False if a residue does not fit in `bits`
+    bool putLimb(const uint64_t* residues, uint32_t n, uint32_t bits);
+    bool putSeed(const uint8_t* seed);
+    bool finish();
+};
+
+// Reads a ciphertext back limb by limb. It never reads past the end of the
+// current ciphertext, so ciphertexts can be stored back to back in one stream.
+class WireDecoder {
+private:
+    std::istream& in;
+    uint8_t buffer[4096];
+    size_t used;
+    size_t available;
+    size_t remaining;       // bytes of the current ciphertext not yet read
+    uint64_t acc;
+    uint32_t accBits;
+
+    bool getByte(uint8_t* byte);
+    bool getBits(uint64_t* value, uint32_t bits);
+
+public:
+    explicit WireDecoder(std::istream& stream);
+
+    // False at end of stream or on a malformed header
+    bool getHeader(CKKSWireHeader* header);
+    bool getLimb(uint64_t* residues, uint32_t n, uint32_t bits);
+    bool getSeed(uint8_t* seed);
+};
+
+// Writes a ciphertext buffer (CKKSLayout.h layout) in wire format.
+// keepLimbs switches the modulus down to q_0 ... q_{keepLimbs-1} before
+// export by dropping the upper RNS limbs; decryption only needs q_0, so the
+// message is unchanged and only unused modulus (remaining depth) is lost.
+// keepLimbs = 0 keeps every limb.
+bool writeWireCiphertext(std::ostream& out, const int64_t* ciphertext, uint32_t polyDegree,
+                         const uint64_t* moduli, uint32_t keepLimbs);
+
+// Reads the next wire ciphertext into a ciphertext buffer. Returns false at
+// end of stream or on malformed input.
+bool readWireCiphertext(std::istream& in, std::vector<int64_t>& ciphertext, uint32_t* polyDegree);
+
+#endif // _WIRE_FORMAT_H_
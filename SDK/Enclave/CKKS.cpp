@@ -1,156 +1,480 @@
 #include "CKKS.h"
-#include "sgx_trts.h"
+#include "MemStats.h"
+#include "Simd.h"
+#include "PhaseStats.h"
 #include <string.h>
+#include <stdlib.h>
 #include <math.h>
-#include "Enclave_t.h"
 
-CKKS::CKKS(const CKKSParams& p) {
-    this->params.polyDegree = (p.polyDegree > MAX_POLY_DEGREE) ? MAX_POLY_DEGREE : p.polyDegree;
+CKKS::CKKS(const CKKSParams& p) : specialNtt(NULL), fftPlan(NULL), zeroPool(NULL) {
+    memset(&keys, 0, sizeof(keys));
+    for (uint32_t j = 0; j < MAX_MODULI; j++) ntt[j] = NULL;
+    // Every table, key and scratch buffer below is sized for this N
+    const bool supported = p.polyDegree >= MIN_POLY_DEGREE && p.polyDegree <= MAX_POLY_DEGREE &&
+                           (p.polyDegree & (p.polyDegree - 1)) == 0;
+    this->params.polyDegree = supported ? p.polyDegree : MIN_POLY_DEGREE;
     this->params.scale = p.scale;
     this->params.slots = p.slots;
+    this->params.numModuli = (p.numModuli > MAX_MODULI) ? MAX_MODULI : p.numModuli;
+
+    if (supported) fftPlan = acquireFftPlan(this->params.polyDegree);
+    this->valid = supported && (this->params.numModuli > 0) && fftPlan != NULL &&
+                  (this->params.slots & (this->params.slots - 1)) == 0 &&
+                  this->params.slots <= this->params.polyDegree / 2;
+    const size_t n = this->params.polyDegree;
+    const size_t evalPolys = EVAL_WORKSPACE_POLYS(this->params.numModuli);
+    scratchPool.init(WORKSPACE_POLYS * (n * sizeof(uint64_t) + WORKSPACE_ALIGNMENT));
+    evalPool.init(evalPolys * (n * sizeof(uint64_t) + WORKSPACE_ALIGNMENT));
+    for (uint32_t j = 0; j < this->params.numModuli; j++) {
+        this->params.moduli[j] = p.moduli[j];
+        if (this->valid) ntt[j] = acquireNttTables(this->params.polyDegree, p.moduli[j]);
+        this->valid = this->valid && ntt[j] != NULL;
+    }
+    this->params.specialModulus = p.specialModulus;
+    if (this->valid) specialNtt = acquireNttTables(this->params.polyDegree, p.specialModulus);
+    this->valid = this->valid && specialNtt != NULL;
+
+    if (this->valid) {
+        const uint32_t L = this->params.numModuli;
+        uint64_t* block = (uint64_t*)calloc(keyWords(), sizeof(uint64_t));
+        this->valid = (block != NULL);
+        if (block != NULL) {
+            memStatsHeapAlloc(keyWords() * sizeof(uint64_t));
+            keys.secretKey = block;
+            keys.publicKey = block + CKKS_KEY_POLYS(CKKS_KEY_SECRET, L) * n;
+            keys.relinKey = keys.publicKey + CKKS_KEY_POLYS(CKKS_KEY_PUBLIC, L) * n;
+        }
+    }
 }
 
 CKKS::~CKKS() {
-    memset(&keys, 0, sizeof(keys));
+    if (keys.secretKey != NULL) {
+        // The block holds the secret key
+        memset(keys.secretKey, 0, keyWords() * sizeof(uint64_t));
+        free(keys.secretKey);
+        memStatsHeapFree(keyWords() * sizeof(uint64_t));
+    }
+    for (uint32_t j = 0; j < MAX_MODULI; j++) releaseNttTables(ntt[j]);
+    releaseNttTables(specialNtt);
+    releaseFftPlan(fftPlan);
 }
 
-int64_t CKKS::sampleTernary() {
-    uint8_t rand_byte;
-    sgx_read_rand(&rand_byte, 1);
-    uint8_t val = rand_byte % 3;
-    return (val == 0) ? -1 : ((val == 1) ? 1 : 0);
+size_t CKKS::keyWords() const {
+    const uint32_t L = params.numModuli;
+    return (CKKS_KEY_POLYS(CKKS_KEY_SECRET, L) + CKKS_KEY_POLYS(CKKS_KEY_PUBLIC, L) +
+            CKKS_KEY_POLYS(CKKS_KEY_RELIN, L)) * params.polyDegree;
 }
 
-int64_t CKKS::sampleError() {
-    uint8_t rand_bytes[2];
-    sgx_read_rand(rand_bytes, 2);
-    uint16_t rand_val = (uint16_t)rand_bytes[0] | ((uint16_t)rand_bytes[1] << 8);
-    double u = rand_val / 65536.0;
-
-    if (u < 0.383) return 0;
-    else if (u < 0.683) return (rand_bytes[0] & 1) ? 1 : -1;
-    else if (u < 0.866) return (rand_bytes[0] & 1) ? 2 : -2;
-    else if (u < 0.954) return (rand_bytes[0] & 1) ? 3 : -3;
-    else if (u < 0.987) return (rand_bytes[0] & 1) ? 4 : -4;
-    else return (rand_bytes[0] & 1) ? 5 : -5;
+uint64_t* CKKS::keyData(uint32_t keyType) const {
+    return (keyType == CKKS_KEY_SECRET) ? keys.secretKey :
+           (keyType == CKKS_KEY_PUBLIC) ? keys.publicKey : keys.relinKey;
 }
 
 sgx_status_t CKKS::keyGen() {
-    // Generate secret key with ternary distribution
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        keys.secretKey[i] = sampleTernary();
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Sampler& sampler = lease.get()->sampler;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    int64_t* s = workspace.take<int64_t>(n);
+    int64_t* e = workspace.take<int64_t>(n);
+    uint64_t* ej = workspace.take<uint64_t>(n);
+    uint64_t* sP = workspace.take<uint64_t>(n);
+    if (s == NULL || e == NULL || ej == NULL || sP == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
     }
 
-    // Modulus for coefficients
-    const int64_t q = (1LL << 40);
+    // Generate secret key with ternary distribution and error, shared by all limbs
+    sampler.sampleTernary(s, n);
+    sampler.sampleGaussian(e, n);
+
+    // Generate public key: (-(a*s + e), a), one residue polynomial per limb,
+    // everything in NTT form
+    for (uint32_t j = 0; j < L; j++) {
+        const Modulus& q = ntt[j]->modulus();
+        uint64_t* sj = keys.secretKey + j * n;
+        uint64_t* bj = keys.publicKey + j * n;
+        uint64_t* aj = keys.publicKey + (L + j) * n;
+
+        for (uint32_t i = 0; i < n; i++) {
+            sj[i] = q.reduceSigned(s[i]);
+            ej[i] = q.reduceSigned(e[i]);
+        }
+        memStatsProbe();
+        ntt[j]->forward(sj);
+        ntt[j]->forward(ej);
+
+        // 'a' is uniform modulo each q_j, hence uniform modulo Q; the NTT is
+        // a bijection, so it can be sampled directly in NTT form
+        sampler.sampleUniform(aj, n, q);
+
+        // Compute -(a*s + e)
+        ntt[j]->multiplyPointwise(aj, sj, bj);
+        for (uint32_t i = 0; i < n; i++) {
+            bj[i] = q.negate(q.add(bj[i], ej[i]));
+        }
+    }
+
+    // Relinearization key: digit j encrypts P*s^2 on limb j under a fresh
+    // 'a' and error. The limbs mod P need s mod P as well.
+    const Modulus& p = specialNtt->modulus();
+    for (uint32_t i = 0; i < n; i++) {
+        sP[i] = p.reduceSigned(s[i]);
+    }
+    specialNtt->forward(sP);
 
-    // Generate public key: (-(a*s + e), a)
-    int64_t a[MAX_POLY_DEGREE];
-    sgx_status_t status = sgx_read_rand((unsigned char*)a, params.polyDegree * sizeof(int64_t));
-    if (status != SGX_SUCCESS) return status;
+    for (uint32_t j = 0; j < L; j++) {
+        uint64_t* digit = keys.relinKey + (size_t)j * 2 * (L + 1) * n;
+        sampler.sampleGaussian(e, n);
 
-    // Ensure 'a' values are properly reduced modulo q
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        a[i] = ((a[i] % q) + q) % q;
+        for (uint32_t k = 0; k <= L; k++) {
+            const NTTTables& tables = keyTables(k);
+            const Modulus& q = tables.modulus();
+            const uint64_t* sk = (k < L) ? keys.secretKey + k * n : sP;
+            uint64_t* bk = digit + (size_t)k * n;
+            uint64_t* ak = digit + (size_t)(L + 1 + k) * n;
+
+            for (uint32_t i = 0; i < n; i++) {
+                ej[i] = q.reduceSigned(e[i]);
+            }
+            memStatsProbe();
+            tables.forward(ej);
+            sampler.sampleUniform(ak, n, q);
+
+            // b = -a*s + e, plus P*s^2 on the digit's own limb
+            tables.multiplyPointwise(ak, sk, bk);
+            for (uint32_t i = 0; i < n; i++) {
+                bk[i] = q.sub(ej[i], bk[i]);
+            }
+            if (k == j) {
+                const uint64_t pModQ = q.reduce(params.specialModulus);
+                for (uint32_t i = 0; i < n; i++) {
+                    bk[i] = q.add(bk[i], q.mul(pModQ, q.mul(sk[i], sk[i])));
+                }
+            }
+        }
     }
 
-    // Generate small error
-    int64_t e[MAX_POLY_DEGREE];
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        e[i] = sampleError();
+    // The secret and the key error must not linger in the scratch arena
+    memset(s, 0, n * sizeof(int64_t));
+    memset(e, 0, n * sizeof(int64_t));
+    memset(ej, 0, n * sizeof(uint64_t));
+    memset(sP, 0, n * sizeof(uint64_t));
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t CKKS::encryptZero(Sampler& sampler, Workspace& workspace, const int64_t* m,
+                               uint64_t* c0, uint64_t* c1) {
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+
+    size_t frame = workspace.mark();
+    int64_t* e1 = workspace.take<int64_t>(n);
+    int64_t* e2 = workspace.take<int64_t>(n);
+    int64_t* u = workspace.take<int64_t>(n);
+    uint64_t* uj = workspace.take<uint64_t>(n);
+    uint64_t* limb = workspace.take<uint64_t>(n);
+    uint64_t* ej = workspace.take<uint64_t>(n);
+    if (e1 == NULL || e2 == NULL || u == NULL || uj == NULL || limb == NULL || ej == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
     }
 
-    // Compute -(a*s + e)
-    int64_t as[MAX_POLY_DEGREE];
-    polyMul(a, keys.secretKey, as, params.polyDegree);
+    // Generate small error polynomials and the ternary encryption randomness
+    sampler.sampleGaussian(e1, n);
+    sampler.sampleGaussian(e2, n);
+    sampler.sampleTernary(u, n);
+    if (m != NULL) {
+        for (uint32_t i = 0; i < n; i++) {
+            e1[i] += m[i];
+        }
+    }
 
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        keys.publicKey[i] = (-(as[i] + e[i]) % q + q) % q;
-        keys.publicKey[i + params.polyDegree] = a[i];
+    // Each limb is an independent ring Z_{q_j}[X]/(X^N + 1). Limbs are
+    // finished in the workspace and copied out whole: on the request ring
+    // c0 and c1 are host memory and must never hold u-dependent products.
+    const SimdKernels& simd = simdKernels();
+    for (uint32_t j = 0; j < L; j++) {
+        const ModulusWords q = ntt[j]->modulus().words();
+
+        // One forward transform of u serves both key products
+        {
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            simd.reduceSigned(u, uj, n, q);
+        }
+        memStatsProbe();
+        ntt[j]->forward(uj);
+
+        // c0 = b*u + e1 + m; e1 already holds e1 + m
+        ntt[j]->multiplyPointwise(keys.publicKey + j * n, uj, limb);
+        ntt[j]->inverse(limb);
+        {
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            simd.reduceSigned(e1, ej, n, q);
+            simd.addMod(limb, ej, limb, n, q);
+        }
+        memcpy(c0 + j * n, limb, n * sizeof(uint64_t));
+
+        // c1 = a*u + e2
+        ntt[j]->multiplyPointwise(keys.publicKey + (L + j) * n, uj, limb);
+        ntt[j]->inverse(limb);
+        {
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            simd.reduceSigned(e2, ej, n, q);
+            simd.addMod(limb, ej, limb, n, q);
+        }
+        memcpy(c1 + j * n, limb, n * sizeof(uint64_t));
     }
 
+    workspace.release(frame);
     return SGX_SUCCESS;
 }
 
+sgx_status_t CKKS::fillZero(uint64_t* entry) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    return encryptZero(lease.get()->sampler, lease.get()->workspace, NULL, entry,
+                       entry + (size_t)params.numModuli * params.polyDegree);
+}
+
 sgx_status_t CKKS::encrypt(const double* msg_real, const double* msg_imag, 
                           uint32_t msg_len, int64_t* ciphertext, uint32_t ct_capacity) {
-    if (ct_capacity < 2 * params.polyDegree) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+
+    const uint32_t n = params.polyDegree;
+    if (ct_capacity < CKKS_CT_WORDS(n, params.numModuli)) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
 
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    int64_t* m = workspace.take<int64_t>(n);
+    if (m == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
     // Encode message into polynomial
-    int64_t m[MAX_POLY_DEGREE] = {0};
-    sgx_status_t status = encode(msg_real, msg_imag, msg_len, m, MAX_POLY_DEGREE);
-    if (status != SGX_SUCCESS) return status;
+    sgx_status_t status = encode(workspace, msg_real, msg_imag, msg_len, m, n);
+    if (status == SGX_SUCCESS) status = encryptPolynomial(lease.get()->sampler, workspace, m, ciphertext);
+    workspace.release(frame);
+    return status;
+}
+
+sgx_status_t CKKS::encryptEncoded(const int64_t* polynomial, uint32_t poly_len, int64_t* ciphertext,
+                                  uint32_t ct_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+    if (poly_len < params.polyDegree || ct_capacity < CKKS_CT_WORDS(params.polyDegree, params.numModuli)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
 
-    // Encrypt the polynomial
-    const int64_t q = (1LL << 40);
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    return encryptPolynomial(lease.get()->sampler, lease.get()->workspace, polynomial, ciphertext);
+}
 
-    // Generate small error polynomials
-    int64_t e1[MAX_POLY_DEGREE] = {0};
-    int64_t e2[MAX_POLY_DEGREE] = {0};
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        e1[i] = sampleError();
-        e2[i] = sampleError();
+sgx_status_t CKKS::encryptPolynomial(Sampler& sampler, Workspace& workspace, const int64_t* m,
+                                     int64_t* ciphertext) {
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+
+    CKKSCiphertextHeader header;
+    header.numModuli = L;
+    header.flags = 0;
+    header.scale = params.scale;
+    memcpy(ciphertext, &header, sizeof(header));
+
+    uint64_t* c0 = (uint64_t*)(ciphertext + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + L * n;
+
+    size_t frame = workspace.mark();
+    uint32_t slot = 0;
+    const uint64_t* zero = (zeroPool != NULL) ? zeroPool->take(&slot) : NULL;
+    uint64_t* mj = (zero != NULL) ? workspace.take<uint64_t>(n) : NULL;
+    if (zero == NULL || mj == NULL) {
+        // Pool empty, or none attached: the whole encryption happens here
+        if (zero != NULL) zeroPool->release(slot);
+        sgx_status_t status = encryptZero(sampler, workspace, m, c0, c1);
+        workspace.release(frame);
+        return status;
     }
 
-    // Generate random polynomial for encryption
-    int64_t u[MAX_POLY_DEGREE] = {0};
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        u[i] = sampleTernary();
+    // c0 = (b*u + e1) + m, c1 = a*u + e2 as precomputed
+    const SimdKernels& simd = simdKernels();
+    for (uint32_t j = 0; j < L; j++) {
+        const ModulusWords q = ntt[j]->modulus().words();
+        PHASE_SCOPE(CKKS_PHASE_REDUCE);
+        simd.reduceSigned(m, mj, n, q);
+        simd.addMod(zero + j * n, mj, c0 + j * n, n, q);
     }
+    memcpy(c1, zero + (size_t)L * n, (size_t)L * n * sizeof(uint64_t));
+    zeroPool->release(slot);
 
-    // Compute c0 = b*u + e1 + m
-    int64_t bu[MAX_POLY_DEGREE] = {0};
-    polyMul(keys.publicKey, u, bu, params.polyDegree);
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
 
-    // Compute c1 = a*u + e2
-    int64_t au[MAX_POLY_DEGREE] = {0};
-    polyMul(keys.publicKey + params.polyDegree, u, au, params.polyDegree);
+sgx_status_t CKKS::encryptSymmetric(const double* msg_real, const double* msg_imag,
+                                   uint32_t msg_len, int64_t* ciphertext, uint32_t ct_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
 
-    // Construct ciphertext
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        // c0 = b*u + e1 + m
-        int64_t sum_c0 = 0;
-        sum_c0 = (sum_c0 + bu[i]) % q;
-        sum_c0 = (sum_c0 + e1[i]) % q;
-        sum_c0 = (sum_c0 + m[i]) % q;
-        ciphertext[i] = (sum_c0 + q) % q;
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+    if (ct_capacity < CKKS_CT_SEEDED_WORDS(n, L)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
 
-        // c1 = a*u + e2
-        int64_t sum_c1 = 0;
-        sum_c1 = (sum_c1 + au[i]) % q;
-        sum_c1 = (sum_c1 + e2[i]) % q;
-        ciphertext[i + params.polyDegree] = (sum_c1 + q) % q;
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Sampler& sampler = lease.get()->sampler;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    int64_t* m = workspace.take<int64_t>(n);
+    int64_t* e = workspace.take<int64_t>(n);
+    uint64_t* aj = workspace.take<uint64_t>(n);
+    if (m == NULL || e == NULL || aj == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+
+    sgx_status_t status = encode(workspace, msg_real, msg_imag, msg_len, m, n);
+    if (status != SGX_SUCCESS) {
+        workspace.release(frame);
+        return status;
+    }
+    sampler.sampleGaussian(e, n);
+    for (uint32_t i = 0; i < n; i++) {
+        e[i] += m[i];
     }
 
+    CKKSCiphertextHeader header;
+    header.numModuli = L;
+    header.flags = CKKS_CT_FLAG_SEEDED;
+    header.scale = params.scale;
+    memcpy(ciphertext, &header, sizeof(header));
+
+    uint64_t* c0 = (uint64_t*)(ciphertext + CKKS_CT_HEADER_WORDS);
+    uint8_t* seed = (uint8_t*)(c0 + L * n);
+
+    // A fresh seed per ciphertext; 'a' is public, only s must stay secret
+    sampler.generate(seed, CKKS_CT_SEED_BYTES);
+    ChaCha20Prng expander;
+    expander.seed(seed, 0);
+
+    const SimdKernels& simd = simdKernels();
+    for (uint32_t j = 0; j < L; j++) {
+        const Modulus& q = ntt[j]->modulus();
+        uint64_t* c0j = c0 + j * n;
+
+        // c0 = -a*s + e + m, with a expanded in NTT form
+        expander.generateUniform(aj, n, q);
+        memStatsProbe();
+        ntt[j]->multiplyPointwise(aj, keys.secretKey + j * n, c0j);
+        ntt[j]->inverse(c0j);
+
+        // aj is free again; e already holds e + m
+        PHASE_SCOPE(CKKS_PHASE_REDUCE);
+        simd.reduceSigned(e, aj, n, q.words());
+        simd.subMod(aj, c0j, c0j, n, q.words());
+    }
+
+    workspace.release(frame);
     return SGX_SUCCESS;
 }
 
 sgx_status_t CKKS::decrypt(const int64_t* ciphertext, uint32_t ct_len,
                            double* msg_real, double* msg_imag, uint32_t msg_capacity) {
-     if (ct_len < 2 * params.polyDegree) {
+     if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+     if (ct_len < CKKS_CT_HEADER_WORDS) return SGX_ERROR_INVALID_PARAMETER;
+
+     const uint32_t n = params.polyDegree;
+     CKKSCiphertextHeader header;
+     memcpy(&header, ciphertext, sizeof(header));
+     const bool seeded = (header.flags == CKKS_CT_FLAG_SEEDED);
+     if (header.numModuli == 0 || header.numModuli > params.numModuli ||
+         (header.flags != 0 && !seeded) || !(header.scale > 0.0) ||
+         ct_len < (seeded ? CKKS_CT_SEEDED_WORDS(n, header.numModuli) : CKKS_CT_WORDS(n, header.numModuli))) {
          return SGX_ERROR_INVALID_PARAMETER;
      }
 
-     const int64_t q = (1LL << 40);
-
-     // Compute c0 + c1*s
-     int64_t c1s[MAX_POLY_DEGREE] = {0};
-     polyMul(ciphertext + params.polyDegree, keys.secretKey, c1s, params.polyDegree);
+     // Only limb 0 is needed: c0 + c1*s = m + e holds modulo every q_j, and
+     // m + e is far below q_0 / 2, so its centered residue mod q_0 is exact.
+     const Modulus& q = ntt[0]->modulus();
+     const uint64_t* c0 = (const uint64_t*)(ciphertext + CKKS_CT_HEADER_WORDS);
+     const uint64_t* c1 = c0 + header.numModuli * n;
+
+     ScratchLease lease(scratchPool);
+     if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+     Workspace& workspace = lease.get()->workspace;
+
+     size_t frame = workspace.mark();
+     uint64_t* c1s = workspace.take<uint64_t>(n);
+     if (c1s == NULL) {
+         workspace.release(frame);
+         return SGX_ERROR_OUT_OF_MEMORY;
+     }
 
-     int64_t m[MAX_POLY_DEGREE] = {0};
-     for (uint32_t i = 0; i < params.polyDegree; i++) {
-         m[i] = (ciphertext[i] + c1s[i]) % q;
-         if (m[i] > q/2) m[i] -= q;  // Ensure values are in [-q/2, q/2]
+     // Compute c0 + c1*s; s is already in NTT form, so c1 takes one
+     // forward and one inverse transform. A seeded c1 is expanded straight
+     // into NTT form; limb 0 is the first one drawn from the seed.
+     if (seeded) {
+         ChaCha20Prng expander;
+         expander.seed((const uint8_t*)c1, 0);
+         expander.generateUniform(c1s, n, q);
+     } else {
+         {
+             PHASE_SCOPE(CKKS_PHASE_REDUCE);
+             for (uint32_t i = 0; i < n; i++) {
+                 c1s[i] = q.reduce(c1[i]);
+             }
+         }
+         ntt[0]->forward(c1s);
+     }
+     memStatsProbe();
+     ntt[0]->multiplyPointwise(c1s, keys.secretKey, c1s);
+     ntt[0]->inverse(c1s);
+
+     // Reuse c1s for the centered message coefficients
+     int64_t* m = (int64_t*)c1s;
+     {
+         PHASE_SCOPE(CKKS_PHASE_REDUCE);
+         for (uint32_t i = 0; i < n; i++) {
+             m[i] = toCentered(q.add(q.reduce(c0[i]), c1s[i]), q.value());
+         }
      }
 
      // Decode the polynomial to get the message
-     return decode(m, params.polyDegree, msg_real, msg_imag, msg_capacity);
+     sgx_status_t status = decode(workspace, m, n, header.scale, msg_real, msg_imag, msg_capacity);
+     workspace.release(frame);
+     return status;
 }
 
-sgx_status_t CKKS::encode(const double* msg_real, const double* msg_imag, 
-                         uint32_t msg_len, int64_t* polynomial, uint32_t poly_capacity) {
+sgx_status_t CKKS::encodeMessage(const double* msg_real, const double* msg_imag, uint32_t msg_len,
+                                 int64_t* polynomial, uint32_t poly_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+
+    ScratchLease lease(scratchPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    return encode(lease.get()->workspace, msg_real, msg_imag, msg_len, polynomial, poly_capacity);
+}
+
+sgx_status_t CKKS::encode(Workspace& workspace, const double* msg_real, const double* msg_imag,
+                          uint32_t msg_len, int64_t* polynomial, uint32_t poly_capacity) {
+    PHASE_SCOPE(CKKS_PHASE_ENCODE);
     if (poly_capacity < params.polyDegree) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
@@ -159,151 +483,145 @@ sgx_status_t CKKS::encode(const double* msg_real, const double* msg_imag,
         msg_len = params.slots; // Truncate if too many values
     }
 
-    // Prepare complex values for FFT
-    complex_t message[MAX_POLY_DEGREE];
-    memset(message, 0, sizeof(message));
+    memStatsProbe();
+    size_t frame = workspace.mark();
+    complex_t* vals = workspace.take<complex_t>(params.slots);
+    if (vals == NULL) return SGX_ERROR_OUT_OF_MEMORY;
 
-    // Place values in the first half of the array
+    // Slot values, zero-padded to the slot count
     for (uint32_t i = 0; i < msg_len; i++) {
-        message[i].real = msg_real[i];
-        message[i].imag = msg_imag[i];
-    }
-
-    // Handle complex conjugate symmetry for real FFT
-    for (uint32_t i = 1; i < params.slots; i++) {
-        if (i < msg_len) {
-            message[params.polyDegree - i].real = msg_real[i];
-            message[params.polyDegree - i].imag = -msg_imag[i];
-        } else {
-            message[params.polyDegree - i].real = 0;
-            message[params.polyDegree - i].imag = 0;
-        }
+        vals[i].real = msg_real[i];
+        vals[i].imag = msg_imag[i];
+    }
+    for (uint32_t i = msg_len; i < params.slots; i++) {
+        vals[i].real = 0.0;
+        vals[i].imag = 0.0;
     }
 
-    // Perform inverse FFT to get polynomial coefficients
-    complex_t coeffs[MAX_POLY_DEGREE];
-    memset(coeffs, 0, sizeof(coeffs));
+    // Interpolate on the N/2 slots; conjugate symmetry makes the
+    // polynomial real, with X^i and X^(i + N/2) carrying real and imaginary parts
+    fftPlan->embedInverse(vals, params.slots);
 
-    fft(message, coeffs, params.polyDegree, true);
+    const uint32_t half = params.polyDegree / 2;
+    const uint32_t gap = half / params.slots;
+    if (gap > 1) {
+        memset(polynomial, 0, params.polyDegree * sizeof(int64_t));
+    }
 
-    // Scale and round to integers
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        polynomial[i] = (int64_t)round(coeffs[i].real * params.scale);
+    // Scale and round to integers; coefficients must stay below q_0 / 2 to
+    // decrypt correctly. Fully packed slots map onto the two halves directly.
+    const double bound = (double)(ntt[0]->modulus().value() / 2);
+    if (gap == 1) {
+        if (!simdKernels().slotsToCoeffs(vals, params.slots, params.scale, bound, polynomial, polynomial + half)) {
+            workspace.release(frame);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+    }
+    for (uint32_t i = 0; gap > 1 && i < params.slots; i++) {
+        double re = round(vals[i].real * params.scale);
+        double im = round(vals[i].imag * params.scale);
+        if (!(fabs(re) < bound) || !(fabs(im) < bound)) {
+            workspace.release(frame);
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        polynomial[i * gap] = (int64_t)re;
+        polynomial[i * gap + half] = (int64_t)im;
     }
 
+    workspace.release(frame);
     return SGX_SUCCESS;
 }
 
-sgx_status_t CKKS::decode(const int64_t* polynomial, uint32_t poly_len,
-                         double* msg_real, double* msg_imag, uint32_t msg_capacity) {
+sgx_status_t CKKS::decode(Workspace& workspace, const int64_t* polynomial, uint32_t poly_len, double scale,
+                          double* msg_real, double* msg_imag, uint32_t msg_capacity) {
+    PHASE_SCOPE(CKKS_PHASE_DECODE);
     if (poly_len < params.polyDegree || msg_capacity < params.slots) {
         return SGX_ERROR_INVALID_PARAMETER;
     }
 
-    const int64_t q = (1LL << 40);
+    const uint32_t half = params.polyDegree / 2;
+    const uint32_t gap = half / params.slots;
 
-    // Convert integer polynomial to complex coefficients
-    complex_t coeffs[MAX_POLY_DEGREE];
-    memset(coeffs, 0, sizeof(coeffs));
+    memStatsProbe();
+    size_t frame = workspace.mark();
+    complex_t* vals = workspace.take<complex_t>(params.slots);
+    if (vals == NULL) return SGX_ERROR_OUT_OF_MEMORY;
 
-    for (uint32_t i = 0; i < params.polyDegree; i++) {
-        int64_t value = polynomial[i] % q;
-        if (value > q/2) value -= q;
-        coeffs[i].real = (double)value / params.scale;
-        coeffs[i].imag = 0.0;
+    // Gather the real/imaginary coefficient pairs (centered representatives)
+    if (gap == 1) {
+        simdKernels().coeffsToSlots(polynomial, polynomial + half, params.slots, scale, vals);
+    }
+    for (uint32_t i = 0; gap > 1 && i < params.slots; i++) {
+        vals[i].real = (double)polynomial[i * gap] / scale;
+        vals[i].imag = (double)polynomial[i * gap + half] / scale;
     }
 
-    // Perform FFT to get the encoded slots
-    complex_t message[MAX_POLY_DEGREE];
-    memset(message, 0, sizeof(message));
-
-    fft(coeffs, message, params.polyDegree, false);
+    // Evaluate at the slot roots
+    fftPlan->embed(vals, params.slots);
 
-    // Extract the message (only the first slots contain the actual data)
-    for (uint32_t i = 0; i < params.slots && i < msg_capacity; i++) {
-        msg_real[i] = message[i].real;
-        msg_imag[i] = message[i].imag;
+    for (uint32_t i = 0; i < params.slots; i++) {
+        msg_real[i] = vals[i].real;
+        msg_imag[i] = vals[i].imag;
     }
 
+    workspace.release(frame);
     return SGX_SUCCESS;
 }
 
-void CKKS::polyMul(const int64_t* a, const int64_t* b, int64_t* result, uint32_t size) {
-    const int64_t q = (1LL << 40);
-    memset(result, 0, size * sizeof(int64_t));
-
-    // Naive polynomial multiplication (can be optimized with NTT for production)
-    for (uint32_t i = 0; i < size; i++) {
-        int64_t a_i = ((a[i] % q) + q) % q;
-        for (uint32_t j = 0; j < size; j++) {
-            uint32_t idx = (i + j) % size;
-            int64_t b_j = ((b[j] % q) + q) % q;
-            int64_t prod = (a_i * b_j) % q;
-            result[idx] = (result[idx] + prod) % q;
-        }
-    }
+static bool validKeyType(uint32_t keyType) {
+    return keyType == CKKS_KEY_SECRET || keyType == CKKS_KEY_PUBLIC || keyType == CKKS_KEY_RELIN;
 }
 
-void CKKS::fft(const complex_t* input, complex_t* output, uint32_t size, bool inverse) {
-    const double PI = 3.14159265358979323846;
-
-    // Copy input to output
-    memcpy(output, input, size * sizeof(complex_t));
+size_t CKKS::keyFileSize(uint32_t keyType) const {
+    return CKKS_KEY_FILE_BYTES(keyType, params.polyDegree, params.numModuli);
+}
 
-    // Bit-reverse permutation
-    uint32_t j = 0;
-    for (uint32_t i = 0; i < size - 1; i++) {
-        if (i < j) {
-            complex_t temp = output[i];
-            output[i] = output[j];
-            output[j] = temp;
-        }
+sgx_status_t CKKS::exportKey(uint32_t keyType, uint8_t* out, size_t capacity) const {
+    if (!valid || !validKeyType(keyType)) return SGX_ERROR_INVALID_PARAMETER;
+    if (capacity < keyFileSize(keyType)) return SGX_ERROR_INVALID_PARAMETER;
+
+    CKKSKeyHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CKKS_KEY_MAGIC;
+    header.version = CKKS_KEY_VERSION;
+    header.keyType = keyType;
+    header.representation = CKKS_REPR_NTT;
+    header.polyDegree = params.polyDegree;
+    header.numModuli = params.numModuli;
+    memcpy(header.moduli, params.moduli, params.numModuli * sizeof(uint64_t));
+    header.specialModulus = params.specialModulus;
+    memcpy(out, &header, sizeof(header));
+
+    memcpy(out + sizeof(header), keyData(keyType), keyFileSize(keyType) - sizeof(header));
+    return SGX_SUCCESS;
+}
 
-        uint32_t mask = size >> 1;
-        while (j & mask) {
-            j &= ~mask;
-            mask >>= 1;
-        }
-        j |= mask;
+sgx_status_t CKKS::importKey(uint32_t keyType, const uint8_t* in, size_t len) {
+    if (!valid || !validKeyType(keyType)) return SGX_ERROR_INVALID_PARAMETER;
+    if (len != keyFileSize(keyType)) return SGX_ERROR_INVALID_PARAMETER;
+
+    CKKSKeyHeader header;
+    memcpy(&header, in, sizeof(header));
+    if (header.magic != CKKS_KEY_MAGIC || header.version != CKKS_KEY_VERSION ||
+        header.keyType != keyType || header.representation != CKKS_REPR_NTT ||
+        header.polyDegree != params.polyDegree || header.numModuli != params.numModuli ||
+        memcmp(header.moduli, params.moduli, params.numModuli * sizeof(uint64_t)) != 0 ||
+        header.specialModulus != params.specialModulus) {
+        return SGX_ERROR_INVALID_PARAMETER;
     }
 
-    // Cooley-Tukey FFT algorithm
-    for (uint32_t step = 2; step <= size; step <<= 1) {
-        double angle = (inverse ? 2.0 : -2.0) * PI / step;
-        complex_t wm = {cos(angle), sin(angle)};
-
-        for (uint32_t i = 0; i < size; i += step) {
-            complex_t w = {1.0, 0.0};
-
-            for (uint32_t k = 0; k < step/2; k++) {
-                complex_t u = output[i + k];
-
-                // Compute t = w * output[i + k + step/2]
-                complex_t t;
-                t.real = w.real * output[i + k + step/2].real - w.imag * output[i + k + step/2].imag;
-                t.imag = w.real * output[i + k + step/2].imag + w.imag * output[i + k + step/2].real;
-
-                // Butterfly operation
-                output[i + k].real = u.real + t.real;
-                output[i + k].imag = u.imag + t.imag;
-
-                output[i + k + step/2].real = u.real - t.real;
-                output[i + k + step/2].imag = u.imag - t.imag;
-
-                // Update w = w * wm
-                double temp = w.real * wm.real - w.imag * wm.imag;
-                w.imag = w.real * wm.imag + w.imag * wm.real;
-                w.real = temp;
-            }
+    // Residues must be reduced for the pointwise products to stay correct
+    const uint32_t n = params.polyDegree;
+    const size_t limbs = CKKS_KEY_POLYS(keyType, params.numModuli);
+    const uint32_t group = (keyType == CKKS_KEY_RELIN) ? params.numModuli + 1 : params.numModuli;
+    const uint64_t* data = (const uint64_t*)(const void*)(in + sizeof(header));
+    for (size_t k = 0; k < limbs; k++) {
+        const uint64_t q = keyTables((uint32_t)(k % group)).modulus().value();
+        for (uint32_t i = 0; i < n; i++) {
+            if (data[k * n + i] >= q) return SGX_ERROR_INVALID_PARAMETER;
         }
     }
 
-    // Scale if inverse
-    if (inverse) {
-        double scale_factor = 1.0 / size;
-        for (uint32_t i = 0; i < size; i++) {
-            output[i].real *= scale_factor;
-            output[i].imag *= scale_factor;
-        }
-    }
+    memcpy(keyData(keyType), data, len - sizeof(header));
+    return SGX_SUCCESS;
 }
@@ -2,55 +2,153 @@
 #ifndef _CKKS_H_
 #define _CKKS_H_
 
-#include "sgx_tcrypto.h"
+#include "Platform.h"
+#include "NTT.h"
+#include "FFT.h"
+#include "ScratchPool.h"
+#include "ZeroPool.h"
+#include "TableCache.h"
+#include "CKKSLayout.h"
 #include <stdint.h>
 
-#define MAX_POLY_DEGREE 8192
+// Scratch polynomials per thread; encrypt holds the most at once (m, e1,
+// e2, u, one limb of u, the limb being finished and a reduced error limb)
+#define WORKSPACE_POLYS 7
+
+// multiply with L limbs: c1 of two seeded operands (2L), the four operand
+// limbs in NTT form, d2 (L), the key-switching accumulators (2(L + 1)) and
+// one lifted digit
+#define EVAL_WORKSPACE_POLYS(numModuli) (5 * (numModuli) + 7)
 
 typedef struct {
     uint32_t polyDegree;
     double scale;
     uint32_t slots;
+    uint32_t numModuli;             // length of the RNS modulus chain
+    uint64_t moduli[MAX_MODULI];    // q_0 (base prime) followed by the scaling primes
+    uint64_t specialModulus;        // P, used only inside key switching
 } CKKSParams;
 
+// Keys are stored per RNS limb: limb j of a polynomial occupies
+// [j * polyDegree, (j + 1) * polyDegree) and holds residues in [0, q_j).
+// Every limb is kept in NTT form, so encrypt and decrypt multiply by the
+// keys pointwise without transforming them again. All three live in one
+// allocation sized for the context's N and chain length.
 typedef struct {
-    double real;
-    double imag;
-} complex_t;
+    uint64_t* secretKey;
+    uint64_t* publicKey;            // b limbs, then a limbs
+    // One (b_j, a_j) pair per RNS digit j with b_j = -a_j*s + e_j + P*g_j*s^2,
+    // where g_j is 1 mod q_j and 0 mod the other limbs. Limb i of component
+    // c of digit j at ((j * 2 + c) * (L + 1) + i) * N, limb L being mod P.
+    uint64_t* relinKey;
+} CKKSKeys;
 
+// Ciphertext operand of the evaluator; c1 points into the workspace when
+// the operand was seeded and had to be expanded
 typedef struct {
-    int64_t secretKey[MAX_POLY_DEGREE];
-    int64_t publicKey[2 * MAX_POLY_DEGREE];
-} CKKSKeys;
+    CKKSCiphertextHeader header;
+    const uint64_t* c0;
+    const uint64_t* c1;
+} CKKSOperand;
 
 class CKKS {
 private:
     CKKSParams params;
     CKKSKeys keys;
+    // Shared with other contexts of the same ring dimension (TableCache.h)
+    const NTTTables* ntt[MAX_MODULI];
+    const NTTTables* specialNtt;
+    const FFTPlan* fftPlan;
+    ScratchPool scratchPool;        // WORKSPACE_POLYS per thread: keys, encrypt, decrypt
+    ScratchPool evalPool;           // EVAL_WORKSPACE_POLYS; slots appear once the evaluator runs
+    ZeroPool* zeroPool;             // optional; owned by the caller
+    bool valid;
 
-    void fft(const complex_t* input, complex_t* output, uint32_t size, bool inverse);
-    void polyMul(const int64_t* a, const int64_t* b, int64_t* result, uint32_t size);
-    int64_t sampleTernary();
-    int64_t sampleError();
-    sgx_status_t encode(const double* msg_real, const double* msg_imag, uint32_t msg_len, 
-                        int64_t* polynomial, uint32_t poly_capacity);
-    sgx_status_t decode(const int64_t* polynomial, uint32_t poly_len,
+    sgx_status_t encode(Workspace& workspace, const double* msg_real, const double* msg_imag,
+                        uint32_t msg_len, int64_t* polynomial, uint32_t poly_capacity);
+    sgx_status_t decode(Workspace& workspace, const int64_t* polynomial, uint32_t poly_len, double scale,
                         double* msg_real, double* msg_imag, uint32_t msg_capacity);
 
+    // c0 = b*u + e1 (+ m) and c1 = a*u + e2, limb by limb; m may be NULL
+    sgx_status_t encryptZero(Sampler& sampler, Workspace& workspace, const int64_t* m, uint64_t* c0, uint64_t* c1);
+    // Public-key encryption of encoded coefficients, through the zero pool if attached
+    sgx_status_t encryptPolynomial(Sampler& sampler, Workspace& workspace, const int64_t* m, int64_t* ciphertext);
+
+    size_t keyWords() const;
+    uint64_t* keyData(uint32_t keyType) const;
+    const NTTTables& keyTables(uint32_t limb) const { return (limb < params.numModuli) ? *ntt[limb] : *specialNtt; }
+    sgx_status_t bindOperand(Workspace& workspace, const int64_t* ciphertext, uint32_t ct_len, CKKSOperand* op);
+    void writeHeader(int64_t* ciphertext, uint32_t numModuli, double scale);
+    sgx_status_t addSub(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                        int64_t* out, uint32_t out_capacity, bool subtract);
+    sgx_status_t keySwitch(Workspace& workspace, const uint64_t* d2, uint32_t level, uint64_t* c0, uint64_t* c1);
+
 public:
     CKKS(const CKKSParams& params);
     ~CKKS();
 
+    // encrypt and decrypt only read the keys and tables and may run
+    // concurrently; keyGen and key loading need exclusive access. Both
+    // read every input word once and validate enclave copies, and write
+    // only finished output, so their buffers may be host memory (the
+    // request ring uses them in place).
     sgx_status_t keyGen();
     sgx_status_t encrypt(const double* msg_real, const double* msg_imag, uint32_t msg_len, 
                          int64_t* ciphertext, uint32_t ct_capacity);
+    // Secret-key encryption into the seeded layout (CKKS_CT_SEEDED_WORDS);
+    // only this context's secret key can decrypt the result
+    sgx_status_t encryptSymmetric(const double* msg_real, const double* msg_imag, uint32_t msg_len,
+                                  int64_t* ciphertext, uint32_t ct_capacity);
+    // Accepts both layouts
     sgx_status_t decrypt(const int64_t* ciphertext, uint32_t ct_len,
                          double* msg_real, double* msg_imag, uint32_t msg_capacity);
+    // With a pool attached, encrypt takes a precomputed encryption of zero
+    // when one is ready and only encodes and adds the message. Entries
+    // are c0 then c1 (zeroWords() in all) and are filled by fillZero().
+    void setZeroPool(ZeroPool* pool) { zeroPool = pool; }
+    size_t zeroWords() const { return 2 * (size_t)params.numModuli * params.polyDegree; }
+    sgx_status_t fillZero(uint64_t* entry);
+    // Encoding alone, into N integer coefficients at the context scale
+    sgx_status_t encodeMessage(const double* msg_real, const double* msg_imag, uint32_t msg_len,
+                               int64_t* polynomial, uint32_t poly_capacity);
+    // encrypt of a message encodeMessage() has already encoded
+    sgx_status_t encryptEncoded(const int64_t* polynomial, uint32_t poly_len, int64_t* ciphertext,
+                                uint32_t ct_capacity);
+
+    // Evaluator (Evaluator.cpp). Inputs may be in either layout; outputs
+    // are regular ciphertexts and must not overlap the inputs. Operands at
+    // different levels are brought to the lower one by dropping limbs.
+    // Decryption reads limb 0 only, so products must be rescaled before
+    // they are decrypted.
+    sgx_status_t add(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                     int64_t* out, uint32_t out_capacity);
+    sgx_status_t sub(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                     int64_t* out, uint32_t out_capacity);
+    // Multiplies by a message encoded at the context scale
+    sgx_status_t multiplyPlain(const int64_t* ct, uint32_t ct_len, const double* msg_real, const double* msg_imag,
+                               uint32_t msg_len, int64_t* out, uint32_t out_capacity);
+    // Tensor product relinearized back to two components
+    sgx_status_t multiply(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                          int64_t* out, uint32_t out_capacity);
+    // Divides by the last prime of the operand's chain and drops that limb
+    sgx_status_t rescale(const int64_t* ct, uint32_t ct_len, int64_t* out, uint32_t out_capacity);
+
+    // False if polyDegree is outside [MIN_POLY_DEGREE, MAX_POLY_DEGREE] or
+    // not a power of two, or the modulus chain is not supported by the
+    // transform tables
+    bool isValid() const { return valid; }
+
+    // Key files (CKKSKeyHeader followed by the limbs); keyType is
+    // CKKS_KEY_SECRET, CKKS_KEY_PUBLIC or CKKS_KEY_RELIN
+    size_t keyFileSize(uint32_t keyType) const;
+    sgx_status_t exportKey(uint32_t keyType, uint8_t* out, size_t capacity) const;
+    sgx_status_t importKey(uint32_t keyType, const uint8_t* in, size_t len);
 
     // Added for benchmarking
     uint32_t getPolyDegree() const { return params.polyDegree; }
-    int64_t* getSecretKey() { return keys.secretKey; }
-    int64_t* getPublicKey() { return keys.publicKey; }
+    uint32_t getNumModuli() const { return params.numModuli; }
+    uint32_t getSlots() const { return params.slots; }
+    const uint64_t* getModuli() const { return params.moduli; }
 };
 
 #endif // _CKKS_H_
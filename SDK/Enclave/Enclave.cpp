@@ -1,66 +1,737 @@
 #include "Enclave_t.h"
 #include "sgx_trts.h"
+#include "sgx_tcrypto.h"
 #include "CKKS.h"
+#include "PlaintextCache.h"
+#include "MemStats.h"
+#include "PhaseStats.h"
+#include "Simd.h"
+#include "CKKSRing.h"
+#include "sgx_thread.h"
 #include <string.h>
+#include <stdlib.h>
 
-static CKKS* g_ckks = NULL;
+// Bounds the [in]/[out] copies the edge routines allocate on the enclave heap
+#define MAX_BATCH_SIZE 64
 
-sgx_status_t ecall_init_ckks(int polyDegree, double scale) {
-    if (g_ckks != NULL) {
-        delete g_ckks;
+// Contexts live side by side, each with its own parameters, keys, zero
+// pool and plaintexts; transform tables are shared through TableCache.h
+#ifndef CKKS_MAX_CONTEXTS
+#define CKKS_MAX_CONTEXTS 16
+#endif
+
+// Key file names are "<name>_secret_key.bin" and so on
+#define MAX_KEY_NAME 200
+// Largest piece of a key file one ocall moves
+#define KEY_CHUNK_BYTES (1 << 20)
+
+// Ecalls that create or destroy a context or write its keys hold its
+// lock exclusively; encrypt/decrypt share it and run concurrently, one per
+// TCS. A handle is (generation << 8) | (index + 1): the generation moves on
+// when the slot is freed, so a stale handle never reaches a new context.
+class ContextSlot {
+public:
+    CKKS* ckks;
+    uint32_t generation;
+    bool reserved;              // taken by a context or one being built
+    sgx_thread_rwlock_t lock;
+    // Outlives the context, so refill workers can wait on it unlocked
+    ZeroPool zeroPool;
+    PlaintextCache plaintexts;
+
+    ContextSlot() : ckks(NULL), generation(1), reserved(false) { sgx_thread_rwlock_init(&lock, NULL); }
+};
+
+static ContextSlot g_contexts[CKKS_MAX_CONTEXTS];
+// Guards `reserved` and the one-time kernel selection
+static sgx_thread_mutex_t g_contextsLock = SGX_THREAD_MUTEX_INITIALIZER;
+static bool g_simdReady = false;
+
+static uint32_t contextHandle(uint32_t index) {
+    return (g_contexts[index].generation << 8) | (index + 1);
+}
+
+// The slot of a live context with its lock held, or NULL (nothing held)
+static ContextSlot* lockContext(uint32_t handle, bool exclusive) {
+    const uint32_t index = (handle & 0xFF) - 1;
+    if (index >= CKKS_MAX_CONTEXTS) return NULL;
+
+    ContextSlot* slot = &g_contexts[index];
+    if (exclusive) {
+        sgx_thread_rwlock_wrlock(&slot->lock);
+    } else {
+        sgx_thread_rwlock_rdlock(&slot->lock);
     }
+    if (slot->ckks != NULL && contextHandle(index) == handle) return slot;
+
+    if (exclusive) {
+        sgx_thread_rwlock_wrunlock(&slot->lock);
+    } else {
+        sgx_thread_rwlock_rdunlock(&slot->lock);
+    }
+    return NULL;
+}
+
+static void unlockContext(ContextSlot* slot, bool exclusive) {
+    if (slot == NULL) return;
+    if (exclusive) {
+        sgx_thread_rwlock_wrunlock(&slot->lock);
+    } else {
+        sgx_thread_rwlock_rdunlock(&slot->lock);
+    }
+}
+
+// Stops the refill workers of a live context; false for a stale handle.
+// Waiting for them must happen before taking the lock exclusively, since
+// each fill holds it shared.
+static bool stopZeroPool(uint32_t handle) {
+    ContextSlot* slot = lockContext(handle, false);
+    if (slot == NULL) return false;
+    unlockContext(slot, false);
+    slot->zeroPool.stop();
+    return true;
+}
+
+static sgx_status_t createContext(int polyDegree, double scale, int depth, int slots, CKKS** ckks) {
+    if (polyDegree <= 0 || depth < 0 || depth >= MAX_MODULI || slots < 0) return SGX_ERROR_INVALID_PARAMETER;
 
     CKKSParams params;
     params.polyDegree = (uint32_t)polyDegree;
     params.scale = scale;
-    params.slots = (uint32_t)(polyDegree / 2);
+    // 0 packs the full N/2 slots; fewer (a power of two) encode sparsely
+    params.slots = (slots > 0) ? (uint32_t)slots : (uint32_t)(polyDegree / 2);
+    params.numModuli = (uint32_t)depth + 1;
+    if (!buildModulusChain(params.polyDegree, scale, (uint32_t)depth, params.moduli) ||
+        !findSpecialModulus(params.polyDegree, params.moduli, params.numModuli, &params.specialModulus)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
 
-    g_ckks = new CKKS(params);
-    return (g_ckks != NULL) ? SGX_SUCCESS : SGX_ERROR_OUT_OF_MEMORY;
+    *ckks = new CKKS(params);
+    if (*ckks == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    memStatsHeapAlloc(sizeof(CKKS));
+    if (!(*ckks)->isValid()) {
+        delete *ckks;
+        *ckks = NULL;
+        memStatsHeapFree(sizeof(CKKS));
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+    return SGX_SUCCESS;
 }
 
-sgx_status_t ecall_generate_keys() {
-    return (g_ckks != NULL) ? g_ckks->keyGen() : SGX_ERROR_UNEXPECTED;
-}
+sgx_status_t ecall_init_ckks(int polyDegree, double scale, int depth, int slots, uint32_t* handle) {
+    memStatsEnter();
+    *handle = 0;
+
+    // Select the vector kernels before the first tables are built, while
+    // no operation can be running
+    sgx_thread_mutex_lock(&g_contextsLock);
+    if (!g_simdReady) {
+        simdInit();
+        g_simdReady = true;
+    }
+    uint32_t index = CKKS_MAX_CONTEXTS;
+    for (uint32_t i = 0; i < CKKS_MAX_CONTEXTS && index == CKKS_MAX_CONTEXTS; i++) {
+        if (!g_contexts[i].reserved) index = i;
+    }
+    if (index < CKKS_MAX_CONTEXTS) g_contexts[index].reserved = true;
+    sgx_thread_mutex_unlock(&g_contextsLock);
+    if (index == CKKS_MAX_CONTEXTS) return SGX_ERROR_OUT_OF_MEMORY;
 
-sgx_status_t ecall_save_keys() {
-    if (g_ckks == NULL) return SGX_ERROR_UNEXPECTED;
+    // Built outside every lock; other contexts keep serving meanwhile
+    CKKS* ckks = NULL;
+    sgx_status_t status = createContext(polyDegree, scale, depth, slots, &ckks);
+    ContextSlot* slot = &g_contexts[index];
+    if (status != SGX_SUCCESS) {
+        sgx_thread_mutex_lock(&g_contextsLock);
+        slot->reserved = false;
+        sgx_thread_mutex_unlock(&g_contextsLock);
+        return status;
+    }
 
-    // Save secret key
-    ocall_save_data((const uint8_t*)g_ckks->getSecretKey(),
-                    g_ckks->getPolyDegree() * sizeof(int64_t),
-                    "ckks_secret_key.bin");
+    sgx_thread_rwlock_wrlock(&slot->lock);
+    slot->zeroPool.configure(0, 0);
+    slot->plaintexts.reset(ckks->getPolyDegree());
+    slot->ckks = ckks;
+    *handle = contextHandle(index);
+    sgx_thread_rwlock_wrunlock(&slot->lock);
+    return SGX_SUCCESS;
+}
 
-    // Save public key
-    ocall_save_data((const uint8_t*)g_ckks->getPublicKey(),
-                    2 * g_ckks->getPolyDegree() * sizeof(int64_t),
-                    "ckks_public_key.bin");
+sgx_status_t ecall_destroy_ckks(uint32_t handle) {
+    memStatsEnter();
+    if (!stopZeroPool(handle)) return SGX_ERROR_INVALID_PARAMETER;
+    ContextSlot* slot = lockContext(handle, true);
+    if (slot == NULL) return SGX_ERROR_INVALID_PARAMETER;
 
+    slot->zeroPool.configure(0, 0);
+    slot->plaintexts.reset(0);
+    delete slot->ckks;
+    slot->ckks = NULL;
+    memStatsHeapFree(sizeof(CKKS));
+    slot->generation = (slot->generation + 1) & 0xFFFFFF;
+    unlockContext(slot, true);
+
+    sgx_thread_mutex_lock(&g_contextsLock);
+    slot->reserved = false;
+    sgx_thread_mutex_unlock(&g_contextsLock);
     return SGX_SUCCESS;
 }
 
-sgx_status_t ecall_load_keys() {
-    if (g_ckks == NULL) return SGX_ERROR_UNEXPECTED;
+sgx_status_t ecall_generate_keys(uint32_t handle) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, true);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = context->ckks->keyGen();
+    context->zeroPool.clear();
+    unlockContext(context, true);
+    return status;
+}
 
-    // Load secret key
-    ocall_load_data((uint8_t*)g_ckks->getSecretKey(),
-                   g_ckks->getPolyDegree() * sizeof(int64_t),
-                   "ckks_secret_key.bin");
+// Key files go through an enclave-side staging buffer that holds the
+// header and the limbs; it may hold the secret key, so it is wiped. The
+// ocalls move it KEY_CHUNK_BYTES at a time: the relinearization key runs
+// to tens of MB at N = 32768, past the host thread's stack.
+static sgx_status_t saveKey(CKKS* ckks, uint32_t keyType, const char* filename) {
+    size_t size = ckks->keyFileSize(keyType);
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (buffer == NULL) return SGX_ERROR_OUT_OF_MEMORY;
 
-    // Load public key
-    ocall_load_data((uint8_t*)g_ckks->getPublicKey(),
-                   2 * g_ckks->getPolyDegree() * sizeof(int64_t),
-                   "ckks_public_key.bin");
+    sgx_status_t status = ckks->exportKey(keyType, buffer, size);
+    for (size_t offset = 0; offset < size && status == SGX_SUCCESS; offset += KEY_CHUNK_BYTES) {
+        const size_t len = (size - offset < KEY_CHUNK_BYTES) ? size - offset : KEY_CHUNK_BYTES;
+        size_t written = 0;
+        status = ocall_save_data(&written, buffer + offset, len, offset, filename);
+        if (status == SGX_SUCCESS && written != len) status = SGX_ERROR_UNEXPECTED;
+    }
 
-    return SGX_SUCCESS;
+    memset(buffer, 0, size);
+    free(buffer);
+    return status;
 }
 
-sgx_status_t ecall_encrypt(const double* msg_real, const double* msg_imag, 
+static sgx_status_t loadKey(CKKS* ckks, uint32_t keyType, const char* filename) {
+    size_t size = ckks->keyFileSize(keyType);
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (buffer == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+
+    sgx_status_t status = SGX_SUCCESS;
+    for (size_t offset = 0; offset < size && status == SGX_SUCCESS; offset += KEY_CHUNK_BYTES) {
+        const size_t len = (size - offset < KEY_CHUNK_BYTES) ? size - offset : KEY_CHUNK_BYTES;
+        size_t bytesRead = 0;
+        status = ocall_load_data(&bytesRead, buffer + offset, len, offset, filename);
+        if (status == SGX_SUCCESS && bytesRead != len) status = SGX_ERROR_INVALID_PARAMETER;
+    }
+    if (status == SGX_SUCCESS) status = ckks->importKey(keyType, buffer, size);
+
+    memset(buffer, 0, size);
+    free(buffer);
+    return status;
+}
+
+static const char* const KEY_SUFFIXES[3] = {"_secret_key.bin", "_public_key.bin", "_relin_key.bin"};
+static const uint32_t KEY_TYPES[3] = {CKKS_KEY_SECRET, CKKS_KEY_PUBLIC, CKKS_KEY_RELIN};
+
+// Saves or loads the secret, public and relinearization keys under `name`
+static sgx_status_t transferKeys(CKKS* ckks, const char* name, bool saving) {
+    const size_t nameLen = strlen(name);
+    if (nameLen == 0 || nameLen > MAX_KEY_NAME) return SGX_ERROR_INVALID_PARAMETER;
+
+    char filename[MAX_KEY_NAME + 32];
+    sgx_status_t status = SGX_SUCCESS;
+    for (int k = 0; k < 3 && status == SGX_SUCCESS; k++) {
+        memcpy(filename, name, nameLen);
+        memcpy(filename + nameLen, KEY_SUFFIXES[k], strlen(KEY_SUFFIXES[k]) + 1);
+        status = saving ? saveKey(ckks, KEY_TYPES[k], filename) : loadKey(ckks, KEY_TYPES[k], filename);
+    }
+    return status;
+}
+
+sgx_status_t ecall_save_keys(uint32_t handle, const char* name) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = transferKeys(context->ckks, name, true);
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_load_keys(uint32_t handle, const char* name) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, true);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = transferKeys(context->ckks, name, false);
+    context->zeroPool.clear();
+    unlockContext(context, true);
+    return status;
+}
+
+// SHA-256 of the values encode reads: the digests of both halves, then
+// one over those and the length
+static sgx_status_t messageDigest(const CKKS* ckks, const double* msg_real, const double* msg_imag,
+                                  uint32_t msg_len, uint8_t* digest) {
+    if (msg_len > ckks->getSlots()) msg_len = ckks->getSlots();
+    const uint32_t bytes = msg_len * (uint32_t)sizeof(double);
+
+    uint8_t parts[2 * sizeof(sgx_sha256_hash_t) + sizeof(uint32_t)];
+    sgx_status_t status = sgx_sha256_msg((const uint8_t*)msg_real, bytes, (sgx_sha256_hash_t*)parts);
+    if (status == SGX_SUCCESS) {
+        status = sgx_sha256_msg((const uint8_t*)msg_imag, bytes,
+                                (sgx_sha256_hash_t*)(parts + sizeof(sgx_sha256_hash_t)));
+    }
+    memcpy(parts + 2 * sizeof(sgx_sha256_hash_t), &msg_len, sizeof(msg_len));
+    if (status == SGX_SUCCESS) status = sgx_sha256_msg(parts, sizeof(parts), (sgx_sha256_hash_t*)digest);
+    return status;
+}
+
+// A held plaintext handle for the message: the cached one while the cache
+// is enabled and has it, otherwise a freshly encoded one
+static sgx_status_t encodePlaintext(ContextSlot* context, const double* msg_real, const double* msg_imag,
+                                    uint32_t msg_len, uint32_t* plaintext) {
+    CKKS* ckks = context->ckks;
+    PlaintextCache& cache = context->plaintexts;
+    uint8_t digest[PLAINTEXT_DIGEST_BYTES];
+    const bool caching = cache.caching();
+    if (caching) {
+        sgx_status_t status = messageDigest(ckks, msg_real, msg_imag, msg_len, digest);
+        if (status != SGX_SUCCESS) return status;
+        if (cache.acquire(digest, plaintext)) return SGX_SUCCESS;
+    }
+
+    int64_t* coeffs = cache.create(plaintext);
+    if (coeffs == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    sgx_status_t status = ckks->encodeMessage(msg_real, msg_imag, msg_len, coeffs, ckks->getPolyDegree());
+    cache.publish(*plaintext, caching ? digest : NULL, status == SGX_SUCCESS);
+    return status;
+}
+
+static sgx_status_t encryptPlaintext(ContextSlot* context, uint32_t plaintext, int64_t* ciphertext,
+                                     uint32_t ct_len) {
+    const int64_t* coeffs = context->plaintexts.get(plaintext);
+    if (coeffs == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = context->ckks->encryptEncoded(coeffs, context->ckks->getPolyDegree(), ciphertext, ct_len);
+    context->plaintexts.put(plaintext);
+    return status;
+}
+
+sgx_status_t ecall_encrypt(uint32_t handle, const double* msg_real, const double* msg_imag, 
                           uint32_t msg_len, int64_t* ciphertext, uint32_t ct_len) {
-    return (g_ckks != NULL) ? g_ckks->encrypt(msg_real, msg_imag, msg_len, ciphertext, ct_len) : SGX_ERROR_UNEXPECTED;
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+
+    // With the plaintext cache enabled a recurring message is encoded once;
+    // if every entry is held, encrypt encodes in place as usual
+    sgx_status_t status = SGX_ERROR_OUT_OF_MEMORY;
+    uint32_t plaintext = 0;
+    if (context->plaintexts.caching()) {
+        status = encodePlaintext(context, msg_real, msg_imag, msg_len, &plaintext);
+        if (status == SGX_SUCCESS) {
+            status = encryptPlaintext(context, plaintext, ciphertext, ct_len);
+            context->plaintexts.release(plaintext);
+        }
+    }
+    if (status == SGX_ERROR_OUT_OF_MEMORY) {
+        status = context->ckks->encrypt(msg_real, msg_imag, msg_len, ciphertext, ct_len);
+    }
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_encrypt_symmetric(uint32_t handle, const double* msg_real, const double* msg_imag,
+                                    uint32_t msg_len, int64_t* ciphertext, uint32_t ct_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL)
+                              ? context->ckks->encryptSymmetric(msg_real, msg_imag, msg_len, ciphertext, ct_len)
+                              : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
 }
 
-sgx_status_t ecall_decrypt(const int64_t* ciphertext, uint32_t ct_len,
+sgx_status_t ecall_decrypt(uint32_t handle, const int64_t* ciphertext, uint32_t ct_len,
                           double* msg_real, double* msg_imag, uint32_t msg_len) {
-    return (g_ckks != NULL) ? g_ckks->decrypt(ciphertext, ct_len, msg_real, msg_imag, msg_len) : SGX_ERROR_UNEXPECTED;
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->decrypt(ciphertext, ct_len, msg_real, msg_imag, msg_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+// Evaluator: results go to a separate output buffer; a product must be
+// rescaled before it is decrypted
+sgx_status_t ecall_add(uint32_t handle, const int64_t* ct1, uint32_t ct1_len, const int64_t* ct2,
+                       uint32_t ct2_len, int64_t* out, uint32_t out_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->add(ct1, ct1_len, ct2, ct2_len, out, out_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_sub(uint32_t handle, const int64_t* ct1, uint32_t ct1_len, const int64_t* ct2,
+                       uint32_t ct2_len, int64_t* out, uint32_t out_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->sub(ct1, ct1_len, ct2, ct2_len, out, out_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_multiply_plain(uint32_t handle, const int64_t* ct, uint32_t ct_len, const double* msg_real,
+                                  const double* msg_imag, uint32_t msg_len, int64_t* out, uint32_t out_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->multiplyPlain(ct, ct_len, msg_real, msg_imag, msg_len,
+                                                                           out, out_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_multiply(uint32_t handle, const int64_t* ct1, uint32_t ct1_len, const int64_t* ct2,
+                            uint32_t ct2_len, int64_t* out, uint32_t out_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->multiply(ct1, ct1_len, ct2, ct2_len, out, out_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_rescale(uint32_t handle, const int64_t* ct, uint32_t ct_len, int64_t* out, uint32_t out_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? context->ckks->rescale(ct, ct_len, out, out_len)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+// Batched variants: batch_size messages of msg_len values and batch_size
+// ciphertexts of ct_len words, each stored back to back, in one transition
+static bool validBatch(uint32_t total_msg_len, uint32_t msg_len, uint32_t total_ct_len,
+                       uint32_t ct_len, uint32_t batch_size) {
+    return batch_size > 0 && batch_size <= MAX_BATCH_SIZE &&
+           (uint64_t)msg_len * batch_size == total_msg_len &&
+           (uint64_t)ct_len * batch_size == total_ct_len;
+}
+
+static sgx_status_t encryptBatch(CKKS* ckks, const double* msg_real, const double* msg_imag,
+                                 uint32_t total_msg_len, uint32_t msg_len,
+                                 int64_t* ciphertexts, uint32_t total_ct_len, uint32_t ct_len,
+                                 uint32_t batch_size) {
+    if (!validBatch(total_msg_len, msg_len, total_ct_len, ct_len, batch_size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    for (uint32_t k = 0; k < batch_size; k++) {
+        sgx_status_t status = ckks->encrypt(msg_real + (size_t)k * msg_len, msg_imag + (size_t)k * msg_len,
+                                            msg_len, ciphertexts + (size_t)k * ct_len, ct_len);
+        if (status != SGX_SUCCESS) return status;
+    }
+    return SGX_SUCCESS;
+}
+
+static sgx_status_t decryptBatch(CKKS* ckks, const int64_t* ciphertexts, uint32_t total_ct_len, uint32_t ct_len,
+                                 double* msg_real, double* msg_imag,
+                                 uint32_t total_msg_len, uint32_t msg_len, uint32_t batch_size) {
+    if (!validBatch(total_msg_len, msg_len, total_ct_len, ct_len, batch_size)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    for (uint32_t k = 0; k < batch_size; k++) {
+        sgx_status_t status = ckks->decrypt(ciphertexts + (size_t)k * ct_len, ct_len,
+                                            msg_real + (size_t)k * msg_len, msg_imag + (size_t)k * msg_len,
+                                            msg_len);
+        if (status != SGX_SUCCESS) return status;
+    }
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_encrypt_batch(uint32_t handle, const double* msg_real, const double* msg_imag,
+                                 uint32_t total_msg_len, uint32_t msg_len,
+                                 int64_t* ciphertexts, uint32_t total_ct_len, uint32_t ct_len,
+                                 uint32_t batch_size) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? encryptBatch(context->ckks, msg_real, msg_imag, total_msg_len,
+                                                           msg_len, ciphertexts, total_ct_len, ct_len, batch_size)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_decrypt_batch(uint32_t handle, const int64_t* ciphertexts, uint32_t total_ct_len,
+                                 uint32_t ct_len, double* msg_real, double* msg_imag,
+                                 uint32_t total_msg_len, uint32_t msg_len, uint32_t batch_size) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    sgx_status_t status = (context != NULL) ? decryptBatch(context->ckks, ciphertexts, total_ct_len, ct_len, msg_real,
+                                                           msg_imag, total_msg_len, msg_len, batch_size)
+                                            : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+// Request ring (ecall_register_ring). The capacity is the enclave's own
+// copy, never re-read from host memory. g_ringLock only guards workers
+// entering and leaving, so the ring cannot be swapped under them.
+static CKKSRingHeader* g_ring = NULL;
+static uint32_t g_ringCapacity = 0;
+static uint32_t g_ringWorkers = 0;
+static sgx_thread_mutex_t g_ringLock = SGX_THREAD_MUTEX_INITIALIZER;
+
+// Empty polls before an idle worker yields its core through an ocall
+#define RING_SPIN_POLLS 1024
+
+sgx_status_t ecall_register_ring(void* ring, size_t bytes) {
+    // NULL unregisters; otherwise the whole ring must be host memory
+    uint32_t capacity = 0;
+    if (ring != NULL) {
+        if (bytes < sizeof(CKKSRingHeader) || !sgx_is_outside_enclave(ring, bytes)) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+        capacity = __atomic_load_n(&((CKKSRingHeader*)ring)->capacity, __ATOMIC_RELAXED);
+        if (capacity == 0 || capacity > CKKS_RING_MAX_CAPACITY || (capacity & (capacity - 1)) != 0 ||
+            bytes < CKKS_RING_BYTES(capacity)) {
+            return SGX_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    sgx_thread_mutex_lock(&g_ringLock);
+    sgx_status_t status = SGX_ERROR_INVALID_STATE;
+    if (g_ringWorkers == 0) {
+        g_ring = (CKKSRingHeader*)ring;
+        g_ringCapacity = capacity;
+        status = SGX_SUCCESS;
+    }
+    sgx_thread_mutex_unlock(&g_ringLock);
+    return status;
+}
+
+// Buffers are used in place and must lie wholly outside the enclave. Each
+// input word is read once: encrypt copies every message value into its
+// slot buffer, and decrypt checks a copy of the ciphertext header and
+// reads every residue once. A host changing a buffer mid-request can only
+// spoil its own result.
+static sgx_status_t serveRingRequest(const CKKSRingRequest& request) {
+    const size_t msgBytes = (size_t)request.msgLen * sizeof(double);
+    const size_t ctBytes = (size_t)request.ctLen * sizeof(int64_t);
+    double* msgReal = (double*)(uintptr_t)request.msgReal;
+    double* msgImag = (double*)(uintptr_t)request.msgImag;
+    int64_t* ciphertext = (int64_t*)(uintptr_t)request.ciphertext;
+    if ((request.op != CKKS_RING_OP_ENCRYPT && request.op != CKKS_RING_OP_DECRYPT) ||
+        msgReal == NULL || msgImag == NULL || ciphertext == NULL || ctBytes < sizeof(CKKSCiphertextHeader) ||
+        !sgx_is_outside_enclave(msgReal, msgBytes) || !sgx_is_outside_enclave(msgImag, msgBytes) ||
+        !sgx_is_outside_enclave(ciphertext, ctBytes)) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    ContextSlot* context = lockContext(request.context, false);
+    sgx_status_t status = SGX_ERROR_INVALID_PARAMETER;
+    if (context != NULL && request.op == CKKS_RING_OP_ENCRYPT) {
+        status = context->ckks->encrypt(msgReal, msgImag, request.msgLen, ciphertext, request.ctLen);
+    } else if (context != NULL) {
+        status = context->ckks->decrypt(ciphertext, request.ctLen, msgReal, msgImag, request.msgLen);
+    }
+    unlockContext(context, false);
+    return status;
+}
+
+// Serves the registered ring until the host sets its stop flag. Occupies
+// one TCS for as long as it runs.
+sgx_status_t ecall_ring_worker() {
+    memStatsEnter();
+    sgx_thread_mutex_lock(&g_ringLock);
+    CKKSRingHeader* ring = g_ring;
+    const uint32_t capacity = g_ringCapacity;
+    if (ring != NULL) g_ringWorkers++;
+    sgx_thread_mutex_unlock(&g_ringLock);
+    if (ring == NULL) return SGX_ERROR_INVALID_STATE;
+
+    uint32_t idle = 0;
+    while (__atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE) == 0) {
+        CKKSRingRequest request;
+        if (!ckksRingNextRequest(ring, capacity, &request)) {
+            if (++idle < RING_SPIN_POLLS) {
+                __builtin_ia32_pause();
+            } else {
+                ocall_ring_idle();
+                idle = 0;
+            }
+            continue;
+        }
+        idle = 0;
+
+        CKKSRingCompletion completion;
+        completion.tag = request.tag;
+        completion.status = (uint32_t)serveRingRequest(request);
+        completion.reserved = 0;
+        // The host keeps no more requests in flight than the ring holds, so
+        // a full completion queue only waits for it to reap
+        while (!ckksRingComplete(ring, capacity, &completion) &&
+               __atomic_load_n(&ring->stop, __ATOMIC_ACQUIRE) == 0) {
+            ocall_ring_idle();
+        }
+    }
+
+    sgx_thread_mutex_lock(&g_ringLock);
+    g_ringWorkers--;
+    sgx_thread_mutex_unlock(&g_ringLock);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_configure_zero_pool(uint32_t handle, uint32_t depth) {
+    memStatsEnter();
+    if (!stopZeroPool(handle)) return SGX_ERROR_INVALID_PARAMETER;
+    ContextSlot* context = lockContext(handle, true);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    context->ckks->setZeroPool(NULL);
+    sgx_status_t status = context->zeroPool.configure(depth, context->ckks->zeroWords());
+    if (status == SGX_SUCCESS && depth > 0) context->ckks->setZeroPool(&context->zeroPool);
+    unlockContext(context, true);
+    return status;
+}
+
+// Fills free entries until the pool is reconfigured or its context is
+// destroyed. Each fill holds the context lock like an encrypt; waiting for
+// a free entry holds nothing.
+sgx_status_t ecall_zero_pool_worker(uint32_t handle) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    ZeroPool& pool = context->zeroPool;
+    const bool entered = pool.enter();
+    unlockContext(context, false);
+    if (!entered) return SGX_ERROR_INVALID_STATE;
+
+    sgx_status_t status = SGX_SUCCESS;
+    for (;;) {
+        uint32_t slot = 0;
+        uint64_t epoch = 0;
+        context = lockContext(handle, false);
+        if (context == NULL) break;
+        const bool claimed = pool.claim(&slot, &epoch);
+        if (claimed) {
+            status = context->ckks->fillZero(pool.entry(slot));
+            pool.filled(slot, status == SGX_SUCCESS);
+        }
+        unlockContext(context, false);
+        if (status != SGX_SUCCESS) break;
+        if (!claimed && !pool.wait(epoch)) break;
+    }
+
+    pool.leave();
+    return status;
+}
+
+sgx_status_t ecall_get_zero_pool_stats(uint32_t handle, uint64_t* hits, uint64_t* misses, uint64_t* refills,
+                                       uint32_t* ready) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    context->zeroPool.getStats(hits, misses, refills, ready);
+    unlockContext(context, false);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_reset_zero_pool_stats(uint32_t handle) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    context->zeroPool.resetStats();
+    unlockContext(context, false);
+    return SGX_SUCCESS;
+}
+
+// Plaintext handles: ecall_encode encodes once, ecall_encrypt_plaintext
+// encrypts without encoding, and the handle stays valid until released
+sgx_status_t ecall_encode(uint32_t handle, const double* msg_real, const double* msg_imag, uint32_t msg_len,
+                          uint32_t* plaintext) {
+    memStatsEnter();
+    *plaintext = 0;
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = encodePlaintext(context, msg_real, msg_imag, msg_len, plaintext);
+    if (status != SGX_SUCCESS) *plaintext = 0;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_encrypt_plaintext(uint32_t handle, uint32_t plaintext, int64_t* ciphertext, uint32_t ct_len) {
+    memStatsEnter();
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = encryptPlaintext(context, plaintext, ciphertext, ct_len);
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_release_plaintext(uint32_t handle, uint32_t plaintext) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = context->plaintexts.release(plaintext) ? SGX_SUCCESS : SGX_ERROR_INVALID_PARAMETER;
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_configure_plaintext_cache(uint32_t handle, uint32_t capacity) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = context->plaintexts.configure(capacity);
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_get_plaintext_cache_stats(uint32_t handle, uint64_t* hits, uint64_t* misses, uint64_t* evictions,
+                                             uint32_t* cached) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    context->plaintexts.getStats(hits, misses, evictions, cached);
+    unlockContext(context, false);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_get_moduli(uint32_t handle, uint64_t* moduli, uint32_t max_moduli, uint32_t* num_moduli) {
+    ContextSlot* context = lockContext(handle, false);
+    if (context == NULL) return SGX_ERROR_INVALID_PARAMETER;
+    sgx_status_t status = SGX_ERROR_INVALID_PARAMETER;
+    CKKS* ckks = context->ckks;
+    if (max_moduli >= ckks->getNumModuli()) {
+        memcpy(moduli, ckks->getModuli(), ckks->getNumModuli() * sizeof(uint64_t));
+        *num_moduli = ckks->getNumModuli();
+        status = SGX_SUCCESS;
+    }
+    unlockContext(context, false);
+    return status;
+}
+
+sgx_status_t ecall_get_simd_level(uint32_t* level) {
+    sgx_thread_mutex_lock(&g_contextsLock);
+    *level = simdLevel();
+    sgx_thread_mutex_unlock(&g_contextsLock);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_get_memory_stats(uint64_t* peak_stack, uint64_t* peak_heap, uint64_t* current_heap) {
+    memStatsGet(peak_stack, peak_heap, current_heap);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_reset_memory_stats() {
+    memStatsReset();
+    return SGX_SUCCESS;
+}
+
+// Calls and TSC cycles per CKKS_PHASE_*; the counters only run in builds
+// with STATS=1
+sgx_status_t ecall_get_stats(uint64_t* calls, uint64_t* cycles, uint32_t num_phases) {
+    if (!phaseStatsGet(calls, cycles, num_phases)) return SGX_ERROR_FEATURE_NOT_SUPPORTED;
+    return SGX_SUCCESS;
+}
+
+sgx_status_t ecall_reset_stats() {
+    phaseStatsReset();
+    return SGX_SUCCESS;
 }
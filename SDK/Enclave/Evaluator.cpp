@@ -0,0 +1,352 @@
+#include "CKKS.h"
+#include "MemStats.h"
+#include "PhaseStats.h"
+#include <string.h>
+#include <math.h>
+
+// Homomorphic operations on ciphertext buffers. Every ciphertext is in
+// coefficient form; products are taken limb by limb in the NTT domain.
+
+// Scales of operands that are added must agree; products and rescaling
+// derive them the same way on both sides, so they match bit for bit or
+// differ by rounding only
+static bool sameScale(double a, double b) {
+    return fabs(a - b) <= 1e-9 * fabs(a);
+}
+
+sgx_status_t CKKS::bindOperand(Workspace& workspace, const int64_t* ciphertext, uint32_t ct_len,
+                               CKKSOperand* op) {
+    const uint32_t n = params.polyDegree;
+    if (ct_len < CKKS_CT_HEADER_WORDS) return SGX_ERROR_INVALID_PARAMETER;
+
+    memcpy(&op->header, ciphertext, sizeof(op->header));
+    const uint32_t level = op->header.numModuli;
+    const bool seeded = (op->header.flags == CKKS_CT_FLAG_SEEDED);
+    if (level == 0 || level > params.numModuli || (op->header.flags != 0 && !seeded) ||
+        !(op->header.scale > 0.0) ||
+        ct_len < (seeded ? CKKS_CT_SEEDED_WORDS(n, level) : CKKS_CT_WORDS(n, level))) {
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    op->c0 = (const uint64_t*)(ciphertext + CKKS_CT_HEADER_WORDS);
+    if (!seeded) {
+        op->c1 = op->c0 + (size_t)level * n;
+        return SGX_SUCCESS;
+    }
+
+    // Expand c1 = INTT(a) from the seed, limbs in the order encryption drew them
+    uint64_t* c1 = workspace.take<uint64_t>((size_t)level * n);
+    if (c1 == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    ChaCha20Prng expander;
+    expander.seed((const uint8_t*)(op->c0 + (size_t)level * n), 0);
+    for (uint32_t j = 0; j < level; j++) {
+        expander.generateUniform(c1 + (size_t)j * n, n, ntt[j]->modulus());
+        ntt[j]->inverse(c1 + (size_t)j * n);
+    }
+    op->c1 = c1;
+    op->header.flags = 0;
+    return SGX_SUCCESS;
+}
+
+void CKKS::writeHeader(int64_t* ciphertext, uint32_t numModuli, double scale) {
+    CKKSCiphertextHeader header;
+    header.numModuli = numModuli;
+    header.flags = 0;
+    header.scale = scale;
+    memcpy(ciphertext, &header, sizeof(header));
+}
+
+sgx_status_t CKKS::addSub(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                          int64_t* out, uint32_t out_capacity, bool subtract) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+    const uint32_t n = params.polyDegree;
+
+    ScratchLease lease(evalPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    CKKSOperand x, y;
+    sgx_status_t status = bindOperand(workspace, a, a_len, &x);
+    if (status == SGX_SUCCESS) status = bindOperand(workspace, b, b_len, &y);
+    if (status != SGX_SUCCESS) {
+        workspace.release(frame);
+        return status;
+    }
+
+    const uint32_t level = (x.header.numModuli < y.header.numModuli) ? x.header.numModuli : y.header.numModuli;
+    if (!sameScale(x.header.scale, y.header.scale) || out_capacity < CKKS_CT_WORDS(n, level)) {
+        workspace.release(frame);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    writeHeader(out, level, x.header.scale);
+    uint64_t* c0 = (uint64_t*)(out + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + (size_t)level * n;
+    PHASE_SCOPE(CKKS_PHASE_REDUCE);
+    for (uint32_t j = 0; j < level; j++) {
+        const Modulus q = ntt[j]->modulus();
+        const size_t offset = (size_t)j * n;
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t x0 = q.reduce(x.c0[offset + i]), y0 = q.reduce(y.c0[offset + i]);
+            uint64_t x1 = q.reduce(x.c1[offset + i]), y1 = q.reduce(y.c1[offset + i]);
+            c0[offset + i] = subtract ? q.sub(x0, y0) : q.add(x0, y0);
+            c1[offset + i] = subtract ? q.sub(x1, y1) : q.add(x1, y1);
+        }
+    }
+
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t CKKS::add(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                       int64_t* out, uint32_t out_capacity) {
+    return addSub(a, a_len, b, b_len, out, out_capacity, false);
+}
+
+sgx_status_t CKKS::sub(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                       int64_t* out, uint32_t out_capacity) {
+    return addSub(a, a_len, b, b_len, out, out_capacity, true);
+}
+
+sgx_status_t CKKS::multiplyPlain(const int64_t* ct, uint32_t ct_len, const double* msg_real, const double* msg_imag,
+                                 uint32_t msg_len, int64_t* out, uint32_t out_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+    const uint32_t n = params.polyDegree;
+
+    ScratchLease lease(evalPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    CKKSOperand x;
+    sgx_status_t status = bindOperand(workspace, ct, ct_len, &x);
+    int64_t* m = workspace.take<int64_t>(n);
+    uint64_t* mj = workspace.take<uint64_t>(n);
+    if (status == SGX_SUCCESS && (m == NULL || mj == NULL)) status = SGX_ERROR_OUT_OF_MEMORY;
+    if (status == SGX_SUCCESS && out_capacity < CKKS_CT_WORDS(n, x.header.numModuli)) {
+        status = SGX_ERROR_INVALID_PARAMETER;
+    }
+    if (status == SGX_SUCCESS) status = encode(workspace, msg_real, msg_imag, msg_len, m, n);
+    if (status != SGX_SUCCESS) {
+        workspace.release(frame);
+        return status;
+    }
+
+    const uint32_t level = x.header.numModuli;
+    writeHeader(out, level, x.header.scale * params.scale);
+    uint64_t* c0 = (uint64_t*)(out + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + (size_t)level * n;
+
+    // One forward transform of the plaintext per limb serves both components
+    for (uint32_t j = 0; j < level; j++) {
+        const Modulus& q = ntt[j]->modulus();
+        const size_t offset = (size_t)j * n;
+        {
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            for (uint32_t i = 0; i < n; i++) {
+                mj[i] = q.reduceSigned(m[i]);
+                c0[offset + i] = q.reduce(x.c0[offset + i]);
+                c1[offset + i] = q.reduce(x.c1[offset + i]);
+            }
+        }
+        memStatsProbe();
+        ntt[j]->forward(mj);
+        ntt[j]->forward(c0 + offset);
+        ntt[j]->forward(c1 + offset);
+        ntt[j]->multiplyPointwise(c0 + offset, mj, c0 + offset);
+        ntt[j]->multiplyPointwise(c1 + offset, mj, c1 + offset);
+        ntt[j]->inverse(c0 + offset);
+        ntt[j]->inverse(c1 + offset);
+    }
+
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t CKKS::keySwitch(Workspace& workspace, const uint64_t* d2, uint32_t level,
+                             uint64_t* c0, uint64_t* c1) {
+    // Hybrid key switching with one digit per RNS limb: every digit d2_j
+    // (residues mod q_j) is lifted to q_0 ... q_{level-1} and P, multiplied
+    // by the key for that digit, and the sum is divided by P on the way back
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+
+    size_t frame = workspace.mark();
+    uint64_t* acc = workspace.take<uint64_t>(2 * (size_t)(level + 1) * n);
+    uint64_t* lifted = workspace.take<uint64_t>(n);
+    if (acc == NULL || lifted == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    memset(acc, 0, 2 * (size_t)(level + 1) * n * sizeof(uint64_t));
+
+    // Accumulator limb k < level is mod q_k, limb `level` is mod P
+    for (uint32_t j = 0; j < level; j++) {
+        const uint64_t* digit = keys.relinKey + (size_t)j * 2 * (L + 1) * n;
+        for (uint32_t k = 0; k <= level; k++) {
+            const uint32_t keyLimb = (k < level) ? k : L;
+            const NTTTables& tables = keyTables(keyLimb);
+            const Modulus& q = tables.modulus();
+
+            {
+                PHASE_SCOPE(CKKS_PHASE_REDUCE);
+                for (uint32_t i = 0; i < n; i++) {
+                    lifted[i] = q.reduce(d2[(size_t)j * n + i]);
+                }
+            }
+            memStatsProbe();
+            tables.forward(lifted);
+            tables.multiplyAccumulate(lifted, digit + (size_t)keyLimb * n, acc + (size_t)k * n);
+            tables.multiplyAccumulate(lifted, digit + (size_t)(L + 1 + keyLimb) * n,
+                                      acc + (size_t)(level + 1 + k) * n);
+        }
+    }
+
+    // Divide by P with rounding: (acc - [acc]_P) / P, then add to (c0, c1)
+    const Modulus& p = specialNtt->modulus();
+    for (uint32_t c = 0; c < 2; c++) {
+        uint64_t* accC = acc + (size_t)c * (level + 1) * n;
+        uint64_t* outC = (c == 0) ? c0 : c1;
+        specialNtt->inverse(accC + (size_t)level * n);
+
+        for (uint32_t k = 0; k < level; k++) {
+            const Modulus& q = ntt[k]->modulus();
+            const uint64_t pInv = q.inverse(q.reduce(p.value()));
+            const uint64_t pInvShoup = q.shoup(pInv);
+            uint64_t* accK = accC + (size_t)k * n;
+            const uint64_t* accP = accC + (size_t)level * n;
+            ntt[k]->inverse(accK);
+
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            for (uint32_t i = 0; i < n; i++) {
+                uint64_t r = q.reduceSigned(toCentered(accP[i], p.value()));
+                uint64_t v = q.mulShoup(q.sub(accK[i], r), pInv, pInvShoup);
+                outC[(size_t)k * n + i] = q.add(outC[(size_t)k * n + i], v);
+            }
+        }
+    }
+
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
+
+sgx_status_t CKKS::multiply(const int64_t* a, uint32_t a_len, const int64_t* b, uint32_t b_len,
+                            int64_t* out, uint32_t out_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+    const uint32_t n = params.polyDegree;
+
+    ScratchLease lease(evalPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    CKKSOperand x, y;
+    sgx_status_t status = bindOperand(workspace, a, a_len, &x);
+    if (status == SGX_SUCCESS) status = bindOperand(workspace, b, b_len, &y);
+    if (status != SGX_SUCCESS) {
+        workspace.release(frame);
+        return status;
+    }
+
+    const uint32_t level = (x.header.numModuli < y.header.numModuli) ? x.header.numModuli : y.header.numModuli;
+    uint64_t* x0 = workspace.take<uint64_t>(n);
+    uint64_t* x1 = workspace.take<uint64_t>(n);
+    uint64_t* y0 = workspace.take<uint64_t>(n);
+    uint64_t* y1 = workspace.take<uint64_t>(n);
+    uint64_t* d2 = workspace.take<uint64_t>((size_t)level * n);
+    if (x0 == NULL || x1 == NULL || y0 == NULL || y1 == NULL || d2 == NULL) {
+        workspace.release(frame);
+        return SGX_ERROR_OUT_OF_MEMORY;
+    }
+    if (out_capacity < CKKS_CT_WORDS(n, level)) {
+        workspace.release(frame);
+        return SGX_ERROR_INVALID_PARAMETER;
+    }
+
+    writeHeader(out, level, x.header.scale * y.header.scale);
+    uint64_t* c0 = (uint64_t*)(out + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + (size_t)level * n;
+
+    // Tensor product (d0, d1, d2) = (x0*y0, x0*y1 + x1*y0, x1*y1)
+    for (uint32_t j = 0; j < level; j++) {
+        const Modulus& q = ntt[j]->modulus();
+        const size_t offset = (size_t)j * n;
+        {
+            PHASE_SCOPE(CKKS_PHASE_REDUCE);
+            for (uint32_t i = 0; i < n; i++) {
+                x0[i] = q.reduce(x.c0[offset + i]);
+                x1[i] = q.reduce(x.c1[offset + i]);
+                y0[i] = q.reduce(y.c0[offset + i]);
+                y1[i] = q.reduce(y.c1[offset + i]);
+            }
+        }
+        memStatsProbe();
+        ntt[j]->forward(x0);
+        ntt[j]->forward(x1);
+        ntt[j]->forward(y0);
+        ntt[j]->forward(y1);
+
+        ntt[j]->multiplyPointwise(x0, y0, c0 + offset);
+        ntt[j]->multiplyPointwise(x0, y1, c1 + offset);
+        ntt[j]->multiplyAccumulate(x1, y0, c1 + offset);
+        ntt[j]->multiplyPointwise(x1, y1, d2 + offset);
+        ntt[j]->inverse(c0 + offset);
+        ntt[j]->inverse(c1 + offset);
+        ntt[j]->inverse(d2 + offset);
+    }
+
+    // Relinearize: fold d2 * s^2 back into (c0, c1)
+    status = keySwitch(workspace, d2, level, c0, c1);
+    workspace.release(frame);
+    return status;
+}
+
+sgx_status_t CKKS::rescale(const int64_t* ct, uint32_t ct_len, int64_t* out, uint32_t out_capacity) {
+    if (!valid) return SGX_ERROR_INVALID_PARAMETER;
+    const uint32_t n = params.polyDegree;
+
+    ScratchLease lease(evalPool);
+    if (lease.get() == NULL) return SGX_ERROR_OUT_OF_MEMORY;
+    Workspace& workspace = lease.get()->workspace;
+
+    size_t frame = workspace.mark();
+    CKKSOperand x;
+    sgx_status_t status = bindOperand(workspace, ct, ct_len, &x);
+    if (status == SGX_SUCCESS && (x.header.numModuli < 2 || out_capacity < CKKS_CT_WORDS(n, x.header.numModuli - 1))) {
+        status = SGX_ERROR_INVALID_PARAMETER;
+    }
+    if (status != SGX_SUCCESS) {
+        workspace.release(frame);
+        return status;
+    }
+
+    // c_k <- (c_k - [c_last]) / q_last for every remaining limb k, with
+    // [c_last] the centered residue, so the division is exact and rounds
+    const uint32_t last = x.header.numModuli - 1;
+    const Modulus& qLast = ntt[last]->modulus();
+    writeHeader(out, last, x.header.scale / (double)qLast.value());
+    uint64_t* c0 = (uint64_t*)(out + CKKS_CT_HEADER_WORDS);
+    uint64_t* c1 = c0 + (size_t)last * n;
+
+    PHASE_SCOPE(CKKS_PHASE_REDUCE);
+    for (uint32_t c = 0; c < 2; c++) {
+        const uint64_t* in = (c == 0) ? x.c0 : x.c1;
+        uint64_t* outC = (c == 0) ? c0 : c1;
+        const uint64_t* inLast = in + (size_t)last * n;
+
+        for (uint32_t k = 0; k < last; k++) {
+            const Modulus& q = ntt[k]->modulus();
+            const uint64_t inv = q.inverse(q.reduce(qLast.value()));
+            const uint64_t invShoup = q.shoup(inv);
+            for (uint32_t i = 0; i < n; i++) {
+                uint64_t r = q.reduceSigned(toCentered(qLast.reduce(inLast[i]), qLast.value()));
+                uint64_t v = q.sub(q.reduce(in[(size_t)k * n + i]), r);
+                outC[(size_t)k * n + i] = q.mulShoup(v, inv, invShoup);
+            }
+        }
+    }
+
+    workspace.release(frame);
+    return SGX_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include "FFT.h"
+#include "Simd.h"
+#include "MemStats.h"
+#include <math.h>
+#include <stdlib.h>
+
+// Bytes of the three tables for ring degree n
+static size_t planBytes(uint32_t n) {
+    return (size_t)(n / 2) * (2 * sizeof(complex_t) + sizeof(uint32_t));
+}
+
+FFTPlan::FFTPlan() : n(0), logSlots(0), twiddles(NULL), twiddlesInv(NULL), bitRev(NULL) {
+}
+
+FFTPlan::~FFTPlan() {
+    if (twiddles != NULL) {
+        free(twiddles);
+        memStatsHeapFree(planBytes(n));
+    }
+}
+
+bool FFTPlan::init(uint32_t degree) {
+    if (degree < 4 || degree > MAX_POLY_DEGREE || (degree & (degree - 1)) != 0) return false;
+
+    if (twiddles != NULL) return false;
+
+    // One allocation: twiddles, inverse twiddles, then the bit reversal
+    twiddles = (complex_t*)malloc(planBytes(degree));
+    if (twiddles == NULL) return false;
+    memStatsHeapAlloc(planBytes(degree));
+    twiddlesInv = twiddles + degree / 2;
+    bitRev = (uint32_t*)(void*)(twiddlesInv + degree / 2);
+
+    const double PI = 3.14159265358979323846;
+    n = degree;
+    const uint32_t m = 2 * n;
+    const uint32_t nh = n / 2;
+
+    logSlots = 0;
+    while ((1U << logSlots) < nh) logSlots++;
+
+    // The layer with blocks of len = 2h slots uses exp(2*pi*i*k / 2N) for
+    // k = (5^j mod 4len) * (2N / 4len), j < h
+    for (uint32_t h = 1; h < nh; h <<= 1) {
+        const uint32_t lenq = 8 * h;
+        const uint32_t gap = m / lenq;
+        uint32_t fivePow = 1;
+        for (uint32_t j = 0; j < h; j++) {
+            double angle = 2.0 * PI * (fivePow * gap) / m;
+            double angleInv = 2.0 * PI * ((lenq - fivePow) * gap) / m;
+            twiddles[h + j].real = cos(angle);
+            twiddles[h + j].imag = sin(angle);
+            twiddlesInv[h + j].real = cos(angleInv);
+            twiddlesInv[h + j].imag = sin(angleInv);
+            fivePow = (fivePow * 5) % lenq;
+        }
+    }
+
+    for (uint32_t i = 0; i < nh; i++) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < logSlots; b++) {
+            r |= ((i >> b) & 1) << (logSlots - 1 - b);
+        }
+        bitRev[i] = r;
+    }
+
+    return true;
+}
+
+void FFTPlan::bitReverse(complex_t* vals, uint32_t slots) const {
+    // Reversal over fewer bits is the full-width reversal shifted down
+    uint32_t logS = 0;
+    while ((1U << logS) < slots) logS++;
+    const uint32_t shift = logSlots - logS;
+
+    for (uint32_t i = 0; i < slots; i++) {
+        uint32_t j = bitRev[i] >> shift;
+        if (i < j) {
+            complex_t temp = vals[i];
+            vals[i] = vals[j];
+            vals[j] = temp;
+        }
+    }
+}
+
+void FFTPlan::embed(complex_t* vals, uint32_t slots) const {
+    const SimdKernels& simd = simdKernels();
+    bitReverse(vals, slots);
+    for (uint32_t h = 1; h < slots; h <<= 1) {
+        simd.fftForwardStage(vals, slots, h, twiddles + h);
+    }
+}
+
+void FFTPlan::embedInverse(complex_t* vals, uint32_t slots) const {
+    const SimdKernels& simd = simdKernels();
+    for (uint32_t h = slots >> 1; h >= 1; h >>= 1) {
+        simd.fftInverseStage(vals, slots, h, twiddlesInv + h);
+    }
+    bitReverse(vals, slots);
+
+    const double scaleFactor = 1.0 / slots;
+    for (uint32_t i = 0; i < slots; i++) {
+        vals[i].real *= scaleFactor;
+        vals[i].imag *= scaleFactor;
+    }
+}
@@ -0,0 +1,45 @@
+// FFT.h - Precomputed canonical-embedding FFT plan for CKKS encode/decode
+#ifndef _FFT_H_
+#define _FFT_H_
+
+#include "CKKSLayout.h"
+#include <stdint.h>
+
+typedef struct {
+    double real;
+    double imag;
+} complex_t;
+
+// Evaluates/interpolates a real polynomial of degree N at the N/2 roots
+// zeta^(5^j) of X^N + 1 (zeta = exp(i*pi/N)). The other N/2 roots are their
+// conjugates, so working on N/2 complex slots replaces the N-point FFT with
+// conjugate padding. All twiddles are tabulated once in init(), laid out
+// per butterfly layer so every layer reads them contiguously.
+class FFTPlan {
+private:
+    uint32_t n;                                     // ring degree N
+    uint32_t logSlots;                              // log2(N/2)
+    // Layer with blocks of 2h slots: twiddle j at [h + j], the root
+    // zeta^(5^j mod 8h) of that layer and its conjugate for the inverse;
+    // N/2 entries each, allocated by init()
+    complex_t* twiddles;
+    complex_t* twiddlesInv;
+    uint32_t* bitRev;                               // bit reversal over log2(N/2) bits
+
+    void bitReverse(complex_t* vals, uint32_t slots) const;
+
+    FFTPlan(const FFTPlan&);
+    FFTPlan& operator=(const FFTPlan&);
+
+public:
+    FFTPlan();
+    ~FFTPlan();
+
+    bool init(uint32_t n);
+
+    // slots is a power of two no larger than N/2
+    void embed(complex_t* vals, uint32_t slots) const;          // coefficients -> slots
+    void embedInverse(complex_t* vals, uint32_t slots) const;   // slots -> coefficients
+};
+
+#endif // _FFT_H_
@@ -0,0 +1,45 @@
+#include "MemStats.h"
+
+// The stack base is per thread; the peaks are shared and updated atomically
+static __thread uintptr_t t_stackBase = 0;
+static uint64_t g_peakStack = 0;
+static uint64_t g_currentHeap = 0;
+static uint64_t g_peakHeap = 0;
+
+static void raisePeak(uint64_t* peak, uint64_t value) {
+    uint64_t seen = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(peak, &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void memStatsEnter() {
+    t_stackBase = (uintptr_t)__builtin_frame_address(0);
+}
+
+__attribute__((noinline)) void memStatsProbe() {
+    volatile uint8_t marker = 0;
+    uintptr_t sp = (uintptr_t)&marker;
+    if (t_stackBase > sp) {
+        raisePeak(&g_peakStack, t_stackBase - sp);
+    }
+}
+
+void memStatsHeapAlloc(size_t bytes) {
+    raisePeak(&g_peakHeap, __atomic_add_fetch(&g_currentHeap, (uint64_t)bytes, __ATOMIC_RELAXED));
+}
+
+void memStatsHeapFree(size_t bytes) {
+    __atomic_sub_fetch(&g_currentHeap, (uint64_t)bytes, __ATOMIC_RELAXED);
+}
+
+void memStatsGet(uint64_t* peakStack, uint64_t* peakHeap, uint64_t* currentHeap) {
+    *peakStack = __atomic_load_n(&g_peakStack, __ATOMIC_RELAXED);
+    *peakHeap = __atomic_load_n(&g_peakHeap, __ATOMIC_RELAXED);
+    *currentHeap = __atomic_load_n(&g_currentHeap, __ATOMIC_RELAXED);
+}
+
+void memStatsReset() {
+    __atomic_store_n(&g_peakStack, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_peakHeap, __atomic_load_n(&g_currentHeap, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+}
@@ -0,0 +1,22 @@
+// MemStats.h - Peak enclave stack and heap tracking for tuning Enclave.config.xml
+#ifndef _MEMSTATS_H_
+#define _MEMSTATS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Stack use is measured from the frame of the ecall that called
+// memStatsEnter() down to the deepest memStatsProbe(); probes sit in the
+// transform and sampling leaves. Heap use counts the CKKS context and its
+// per-thread scratch, which dominate enclave allocations. For a complete picture,
+// run the enclave under sgx_emmt.
+void memStatsEnter();
+void memStatsProbe();
+
+void memStatsHeapAlloc(size_t bytes);
+void memStatsHeapFree(size_t bytes);
+
+void memStatsGet(uint64_t* peakStack, uint64_t* peakHeap, uint64_t* currentHeap);
+void memStatsReset();
+
+#endif // _MEMSTATS_H_
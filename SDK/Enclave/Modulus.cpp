@@ -0,0 +1,94 @@
+#include "Modulus.h"
+#include <math.h>
+
+bool isPrime(uint64_t value) {
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    const uint32_t numBases = sizeof(bases) / sizeof(bases[0]);
+
+    if (value < 2) return false;
+    for (uint32_t i = 0; i < numBases; i++) {
+        if (value % bases[i] == 0) return value == bases[i];
+    }
+
+    uint64_t d = value - 1;
+    uint32_t s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+
+    Modulus mod(value);
+    for (uint32_t i = 0; i < numBases; i++) {
+        uint64_t x = mod.pow(bases[i], d);
+        if (x == 1 || x == value - 1) continue;
+
+        bool composite = true;
+        for (uint32_t r = 1; r < s; r++) {
+            x = mod.mul(x, x);
+            if (x == value - 1) {
+                composite = false;
+                break;
+            }
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+static bool inChain(const uint64_t* moduli, uint32_t count, uint64_t value) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (moduli[i] == value) return true;
+    }
+    return false;
+}
+
+bool buildModulusChain(uint32_t n, double scale, uint32_t depth, uint64_t* moduli) {
+    const uint64_t step = 2ULL * n;
+    const uint64_t baseBits = 60;
+
+    if (scale < (double)(step * 4) || scale >= ldexp(1.0, (int)baseBits - 1)) return false;
+
+    // Base prime: largest 60-bit prime in the congruence class
+    uint64_t candidate = ((1ULL << baseBits) / step) * step + 1;
+    do {
+        candidate -= step;
+    } while (!isPrime(candidate));
+    moduli[0] = candidate;
+
+    // Scaling primes: alternate above and below the scale so their product
+    // tracks scale^depth and rescaled ciphertexts keep a scale close to it
+    uint64_t center = ((uint64_t)scale / step) * step + 1;
+    uint64_t up = center;
+    uint64_t down = center;
+    for (uint32_t i = 1; i <= depth; i++) {
+        uint64_t prime = 0;
+        if (i & 1) {
+            while (prime == 0) {
+                if (isPrime(up) && !inChain(moduli, i, up)) prime = up;
+                up += step;
+            }
+        } else {
+            while (prime == 0) {
+                if (down <= step) return false;
+                down -= step;
+                if (isPrime(down) && !inChain(moduli, i, down)) prime = down;
+            }
+        }
+        moduli[i] = prime;
+    }
+
+    return true;
+}
+
+bool findSpecialModulus(uint32_t n, const uint64_t* moduli, uint32_t count, uint64_t* special) {
+    const uint64_t step = 2ULL * n;
+
+    uint64_t candidate = ((1ULL << MAX_MODULUS_BITS) / step) * step + 1;
+    do {
+        candidate -= step;
+        if (candidate <= step) return false;
+    } while (!isPrime(candidate) || inChain(moduli, count, candidate));
+
+    *special = candidate;
+    return true;
+}
@@ -0,0 +1,141 @@
+// Modulus.h - Word-sized prime modulus with Barrett and Shoup reduction
+#ifndef _MODULUS_H_
+#define _MODULUS_H_
+
+#include <stdint.h>
+
+typedef unsigned __int128 uint128_t;
+
+// Upper bound on the bit width of a modulus; keeps a + b < 2^63 and lets a
+// single conditional subtraction finish every reduction below.
+#define MAX_MODULUS_BITS 61
+
+static inline uint64_t mulHi64(uint64_t a, uint64_t b) {
+    return (uint64_t)(((uint128_t)a * b) >> 64);
+}
+
+// Maps a residue in [0, q) to its centered representative in (-q/2, q/2]
+static inline int64_t toCentered(uint64_t value, uint64_t q) {
+    return (value > q / 2) ? (int64_t)value - (int64_t)q : (int64_t)value;
+}
+
+// A modulus and its Barrett ratio as plain words, the form in which the
+// vector kernels (Simd.h) take it
+typedef struct {
+    uint64_t value;
+    uint64_t ratioHi;
+    uint64_t ratioLo;
+} ModulusWords;
+
+class Modulus {
+private:
+    uint64_t q;
+    uint64_t ratioHi;    // floor(2^128 / q), high word
+    uint64_t ratioLo;    // floor(2^128 / q), low word
+
+public:
+    Modulus() : q(0), ratioHi(0), ratioLo(0) {}
+    explicit Modulus(uint64_t value) { set(value); }
+    explicit Modulus(const ModulusWords& w) : q(w.value), ratioHi(w.ratioHi), ratioLo(w.ratioLo) {}
+
+    void set(uint64_t value) {
+        q = value;
+        uint128_t ratio = ~(uint128_t)0 / value;
+        ratioHi = (uint64_t)(ratio >> 64);
+        ratioLo = (uint64_t)ratio;
+    }
+
+    uint64_t value() const { return q; }
+
+    ModulusWords words() const {
+        ModulusWords w;
+        w.value = q;
+        w.ratioHi = ratioHi;
+        w.ratioLo = ratioLo;
+        return w;
+    }
+
+    uint64_t add(uint64_t a, uint64_t b) const {
+        uint64_t r = a + b;
+        return (r >= q) ? r - q : r;
+    }
+
+    uint64_t sub(uint64_t a, uint64_t b) const {
+        return (a >= b) ? a - b : a + q - b;
+    }
+
+    uint64_t negate(uint64_t a) const {
+        return (a == 0) ? 0 : q - a;
+    }
+
+    // Any 64-bit word to [0, q)
+    uint64_t reduce(uint64_t a) const {
+        uint64_t r = a - mulHi64(a, ratioHi) * q;
+        return (r >= q) ? r - q : r;
+    }
+
+    // Signed word to [0, q)
+    uint64_t reduceSigned(int64_t a) const {
+        uint64_t r = reduce((a < 0) ? (uint64_t)0 - (uint64_t)a : (uint64_t)a);
+        return (a < 0) ? negate(r) : r;
+    }
+
+    // Barrett reduction of a 128-bit value (zHi:zLo)
+    uint64_t reduce128(uint64_t zHi, uint64_t zLo) const {
+        uint64_t carry = mulHi64(zLo, ratioLo);
+        uint128_t t = (uint128_t)zLo * ratioHi + carry;
+        uint64_t tmp1 = (uint64_t)t;
+        uint64_t tmp3 = (uint64_t)(t >> 64);
+        t = (uint128_t)zHi * ratioLo + tmp1;
+        carry = (uint64_t)(t >> 64);
+        uint64_t quot = zHi * ratioHi + tmp3 + carry;
+
+        uint64_t r = zLo - quot * q;
+        return (r >= q) ? r - q : r;
+    }
+
+    uint64_t mul(uint64_t a, uint64_t b) const {
+        uint128_t z = (uint128_t)a * b;
+        return reduce128((uint64_t)(z >> 64), (uint64_t)z);
+    }
+
+    // Shoup companion floor(w * 2^64 / q) for repeated multiplication by w
+    uint64_t shoup(uint64_t w) const {
+        return (uint64_t)(((uint128_t)w << 64) / q);
+    }
+
+    uint64_t mulShoup(uint64_t a, uint64_t w, uint64_t wShoup) const {
+        uint64_t r = a * w - mulHi64(a, wShoup) * q;
+        return (r >= q) ? r - q : r;
+    }
+
+    uint64_t pow(uint64_t base, uint64_t exp) const {
+        uint64_t result = 1;
+        while (exp) {
+            if (exp & 1) result = mul(result, base);
+            base = mul(base, base);
+            exp >>= 1;
+        }
+        return result;
+    }
+
+    // Inverse modulo a prime q
+    uint64_t inverse(uint64_t a) const {
+        return pow(a, q - 2);
+    }
+};
+
+// Deterministic Miller-Rabin for 64-bit values
+bool isPrime(uint64_t value);
+
+// Builds the RNS chain for ring degree n: moduli[0] is a 60-bit base prime
+// that holds the decrypted message, followed by `depth` primes close to
+// `scale` that are consumed by rescaling. Every prime is 1 mod 2n.
+bool buildModulusChain(uint32_t n, double scale, uint32_t depth, uint64_t* moduli);
+
+// Special prime P for key switching: the largest 61-bit prime that is 1 mod
+// 2n and not in the chain. P exceeds every q_j, which keeps the noise that
+// key switching adds after dividing by P small.
+bool findSpecialModulus(uint32_t n, const uint64_t* moduli, uint32_t count, uint64_t* special);
+
+#endif // _MODULUS_H_
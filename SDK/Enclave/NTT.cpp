@@ -0,0 +1,114 @@
+#include "NTT.h"
+#include "Simd.h"
+#include "MemStats.h"
+#include "PhaseStats.h"
+#include <string.h>
+#include <stdlib.h>
+
+static inline uint32_t bitReverse(uint32_t x, uint32_t bits) {
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < bits; i++) {
+        r = (r << 1) | (x & 1);
+        x >>= 1;
+    }
+    return r;
+}
+
+NTTTables::NTTTables()
+    : n(0), logN(0), tables(NULL), psiRev(NULL), psiRevShoup(NULL), psiInvRev(NULL), psiInvRevShoup(NULL),
+      nInv(0), nInvShoup(0) {
+}
+
+NTTTables::~NTTTables() {
+    if (tables != NULL) {
+        free(tables);
+        memStatsHeapFree(4 * (size_t)n * sizeof(uint64_t));
+    }
+}
+
+bool NTTTables::init(uint32_t degree, const Modulus& modulus) {
+    const uint64_t p = modulus.value();
+    if (degree < 2 || degree > MAX_POLY_DEGREE || (degree & (degree - 1)) != 0) return false;
+    if (p >= (1ULL << MAX_MODULUS_BITS) || (p - 1) % (2ULL * degree) != 0) return false;
+
+    // Tables are built once per context
+    if (tables != NULL) return false;
+    tables = (uint64_t*)malloc(4 * (size_t)degree * sizeof(uint64_t));
+    if (tables == NULL) return false;
+    memStatsHeapAlloc(4 * (size_t)degree * sizeof(uint64_t));
+    psiRev = tables;
+    psiRevShoup = tables + degree;
+    psiInvRev = tables + 2 * (size_t)degree;
+    psiInvRevShoup = tables + 3 * (size_t)degree;
+
+    n = degree;
+    q = modulus;
+    logN = 0;
+    while ((1U << logN) < n) logN++;
+
+    // Find a primitive 2n-th root of unity: psi^n = -1 implies order 2n
+    uint64_t psi = 0;
+    for (uint64_t x = 2; x < p; x++) {
+        uint64_t g = q.pow(x, (p - 1) / (2ULL * n));
+        if (q.pow(g, n) == p - 1) {
+            psi = g;
+            break;
+        }
+    }
+    if (psi == 0) return false;
+
+    uint64_t psiInv = q.inverse(psi);
+    uint64_t power = 1;
+    uint64_t powerInv = 1;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t r = bitReverse(i, logN);
+        psiRev[r] = power;
+        psiInvRev[r] = powerInv;
+        power = q.mul(power, psi);
+        powerInv = q.mul(powerInv, psiInv);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        psiRevShoup[i] = q.shoup(psiRev[i]);
+        psiInvRevShoup[i] = q.shoup(psiInvRev[i]);
+    }
+
+    nInv = q.inverse(n);
+    nInvShoup = q.shoup(nInv);
+    return true;
+}
+
+void NTTTables::forward(uint64_t* a) const {
+    PHASE_SCOPE(CKKS_PHASE_TRANSFORM);
+    // Cooley-Tukey butterflies with psi folded into the twiddles, so no
+    // separate pre-multiplication is needed for the negacyclic wrap
+    const SimdKernels& simd = simdKernels();
+    const ModulusWords words = q.words();
+    uint32_t t = n;
+    for (uint32_t m = 1; m < n; m <<= 1) {
+        t >>= 1;
+        simd.nttForwardStage(a, m, t, psiRev, psiRevShoup, words);
+    }
+}
+
+void NTTTables::inverse(uint64_t* a) const {
+    PHASE_SCOPE(CKKS_PHASE_TRANSFORM);
+    // Gentleman-Sande butterflies, consuming bit-reversed input
+    const SimdKernels& simd = simdKernels();
+    const ModulusWords words = q.words();
+    uint32_t t = 1;
+    for (uint32_t m = n; m > 1; m >>= 1) {
+        simd.nttInverseStage(a, m >> 1, t, psiInvRev, psiInvRevShoup, words);
+        t <<= 1;
+    }
+    simd.mulScalarMod(a, nInv, nInvShoup, a, n, words);
+}
+
+void NTTTables::multiplyPointwise(const uint64_t* a, const uint64_t* b, uint64_t* result) const {
+    PHASE_SCOPE(CKKS_PHASE_PRODUCT);
+    simdKernels().mulMod(a, b, result, n, q.words());
+}
+
+void NTTTables::multiplyAccumulate(const uint64_t* a, const uint64_t* b, uint64_t* acc) const {
+    PHASE_SCOPE(CKKS_PHASE_PRODUCT);
+    simdKernels().mulAddMod(a, b, acc, n, q.words());
+}
@@ -0,0 +1,47 @@
+// NTT.h - Negacyclic number-theoretic transform over Z_q[X]/(X^N + 1)
+#ifndef _NTT_H_
+#define _NTT_H_
+
+#include "Modulus.h"
+#include "CKKSLayout.h"
+#include <stdint.h>
+
+class NTTTables {
+private:
+    uint32_t n;
+    uint32_t logN;
+    Modulus q;
+
+    // Powers of the primitive 2N-th root psi in bit-reversed order, with
+    // their Shoup companions floor(w * 2^64 / q); N words each, carved
+    // from one allocation made by init()
+    uint64_t* tables;
+    uint64_t* psiRev;
+    uint64_t* psiRevShoup;
+    uint64_t* psiInvRev;
+    uint64_t* psiInvRevShoup;
+    uint64_t nInv;
+    uint64_t nInvShoup;
+
+    NTTTables(const NTTTables&);
+    NTTTables& operator=(const NTTTables&);
+
+public:
+    NTTTables();
+    ~NTTTables();
+
+    // Builds the root tables for degree n (power of two) and prime q = 1 mod 2n.
+    bool init(uint32_t n, const Modulus& q);
+
+    const Modulus& modulus() const { return q; }
+
+    // In-place transforms. forward() leaves the result in bit-reversed order,
+    // which inverse() expects; pointwise products do not care about order.
+    void forward(uint64_t* a) const;
+    void inverse(uint64_t* a) const;
+    void multiplyPointwise(const uint64_t* a, const uint64_t* b, uint64_t* result) const;
+    // acc += a * b
+    void multiplyAccumulate(const uint64_t* a, const uint64_t* b, uint64_t* acc) const;
+};
+
+#endif // _NTT_H_
@@ -0,0 +1,25 @@
+#include "PhaseStats.h"
+
+// Shared by all threads; relaxed atomics suffice for counters
+static uint64_t g_calls[CKKS_PHASE_COUNT];
+static uint64_t g_cycles[CKKS_PHASE_COUNT];
+
+void phaseStatsAdd(uint32_t phase, uint64_t cycles) {
+    __atomic_add_fetch(&g_calls[phase], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&g_cycles[phase], cycles, __ATOMIC_RELAXED);
+}
+
+bool phaseStatsGet(uint64_t* calls, uint64_t* cycles, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        calls[i] = (i < CKKS_PHASE_COUNT) ? __atomic_load_n(&g_calls[i], __ATOMIC_RELAXED) : 0;
+        cycles[i] = (i < CKKS_PHASE_COUNT) ? __atomic_load_n(&g_cycles[i], __ATOMIC_RELAXED) : 0;
+    }
+    return CKKS_PHASE_STATS != 0;
+}
+
+void phaseStatsReset() {
+    for (uint32_t i = 0; i < CKKS_PHASE_COUNT; i++) {
+        __atomic_store_n(&g_calls[i], 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&g_cycles[i], 0, __ATOMIC_RELAXED);
+    }
+}
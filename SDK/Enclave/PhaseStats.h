@@ -0,0 +1,40 @@
+// PhaseStats.h - Per-phase call and cycle counters for the CKKS hot paths
+#ifndef _PHASE_STATS_H_
+#define _PHASE_STATS_H_
+
+#include "CKKSStats.h"
+#include <stdint.h>
+
+// Built in with -DCKKS_PHASE_STATS=1 (make STATS=1). Cycles come from
+// RDTSC, which faults inside SGX1 enclaves, so the counters need SGX2
+// hardware or simulation mode; by default PHASE_SCOPE compiles to nothing.
+#ifndef CKKS_PHASE_STATS
+#define CKKS_PHASE_STATS 0
+#endif
+
+void phaseStatsAdd(uint32_t phase, uint64_t cycles);
+// False when built without CKKS_PHASE_STATS
+bool phaseStatsGet(uint64_t* calls, uint64_t* cycles, uint32_t count);
+void phaseStatsReset();
+
+#if CKKS_PHASE_STATS
+// Times the rest of the enclosing block
+class PhaseScope {
+private:
+    uint32_t phase;
+    uint64_t start;
+
+    PhaseScope(const PhaseScope&);
+    PhaseScope& operator=(const PhaseScope&);
+
+public:
+    explicit PhaseScope(uint32_t p) : phase(p), start(__builtin_ia32_rdtsc()) {}
+    ~PhaseScope() { phaseStatsAdd(phase, __builtin_ia32_rdtsc() - start); }
+};
+
+#define PHASE_SCOPE(phase) PhaseScope phaseScope(phase)
+#else
+#define PHASE_SCOPE(phase) do { } while (0)
+#endif
+
+#endif // _PHASE_STATS_H_
@@ -0,0 +1,220 @@
+#include "PlaintextCache.h"
+#include "MemStats.h"
+#include <string.h>
+#include <stdlib.h>
+
+enum {
+    PLAINTEXT_FREE = 0,
+    PLAINTEXT_ENCODING,
+    PLAINTEXT_READY
+};
+
+PlaintextCache::PlaintextCache()
+    : polyWords(0), capacity(0), cached(0), tick(0), hits(0), misses(0), evictions(0) {
+    memset(entries, 0, sizeof(entries));
+    for (uint32_t i = 0; i < PLAINTEXT_MAX_ENTRIES; i++) entries[i].generation = 1;
+    sgx_thread_mutex_init(&lock, NULL);
+}
+
+PlaintextCache::~PlaintextCache() {
+    reset(0);
+    sgx_thread_mutex_destroy(&lock);
+}
+
+PlaintextCache::Entry* PlaintextCache::find(uint32_t handle) {
+    const uint32_t index = (handle & 0xFFFF) - 1;
+    if (index >= PLAINTEXT_MAX_ENTRIES || handleOf(index) != handle) return NULL;
+    return (entries[index].state == PLAINTEXT_FREE) ? NULL : &entries[index];
+}
+
+void PlaintextCache::freeEntry(Entry& entry) {
+    if (entry.coeffs != NULL) {
+        // The coefficients are the message
+        memset(entry.coeffs, 0, polyWords * sizeof(int64_t));
+        free(entry.coeffs);
+        memStatsHeapFree(polyWords * sizeof(int64_t));
+    }
+    entry.coeffs = NULL;
+    entry.held = 0;
+    entry.users = 0;
+    entry.hasDigest = false;
+    entry.state = PLAINTEXT_FREE;
+    entry.generation = (entry.generation + 1) & 0xFFFF;
+    if (entry.generation == 0) entry.generation = 1;
+}
+
+uint32_t PlaintextCache::firstFree() const {
+    for (uint32_t i = 0; i < PLAINTEXT_MAX_ENTRIES; i++) {
+        if (entries[i].state == PLAINTEXT_FREE) return i;
+    }
+    return PLAINTEXT_MAX_ENTRIES;
+}
+
+bool PlaintextCache::evictOldest() {
+    Entry* oldest = NULL;
+    for (uint32_t i = 0; i < PLAINTEXT_MAX_ENTRIES; i++) {
+        Entry& entry = entries[i];
+        if (entry.state == PLAINTEXT_READY && entry.held == 0 && entry.users == 0 &&
+            (oldest == NULL || entry.lastUse < oldest->lastUse)) {
+            oldest = &entry;
+        }
+    }
+    if (oldest == NULL) return false;
+    freeEntry(*oldest);
+    cached--;
+    evictions++;
+    return true;
+}
+
+// Called once nobody holds or reads the entry
+void PlaintextCache::unused(Entry& entry) {
+    if (capacity == 0 || !entry.hasDigest) {
+        freeEntry(entry);
+        return;
+    }
+    entry.lastUse = ++tick;
+    cached++;
+    while (cached > capacity) {
+        if (!evictOldest()) break;
+    }
+}
+
+void PlaintextCache::reset(size_t words) {
+    sgx_thread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < PLAINTEXT_MAX_ENTRIES; i++) {
+        if (entries[i].state != PLAINTEXT_FREE) freeEntry(entries[i]);
+    }
+    polyWords = words;
+    capacity = 0;
+    cached = 0;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    sgx_thread_mutex_unlock(&lock);
+}
+
+sgx_status_t PlaintextCache::configure(uint32_t newCapacity) {
+    if (newCapacity > PLAINTEXT_MAX_ENTRIES) return SGX_ERROR_INVALID_PARAMETER;
+
+    sgx_thread_mutex_lock(&lock);
+    capacity = newCapacity;
+    while (cached > capacity) {
+        if (!evictOldest()) break;
+    }
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    sgx_thread_mutex_unlock(&lock);
+    return SGX_SUCCESS;
+}
+
+bool PlaintextCache::caching() {
+    sgx_thread_mutex_lock(&lock);
+    const bool enabled = (capacity > 0);
+    sgx_thread_mutex_unlock(&lock);
+    return enabled;
+}
+
+bool PlaintextCache::acquire(const uint8_t* digest, uint32_t* handle) {
+    sgx_thread_mutex_lock(&lock);
+    bool found = false;
+    for (uint32_t i = 0; i < PLAINTEXT_MAX_ENTRIES && capacity > 0; i++) {
+        Entry& entry = entries[i];
+        if (entry.state == PLAINTEXT_READY && entry.hasDigest &&
+            memcmp(entry.digest, digest, PLAINTEXT_DIGEST_BYTES) == 0) {
+            if (entry.held == 0 && entry.users == 0) cached--;
+            entry.held++;
+            *handle = handleOf(i);
+            found = true;
+            break;
+        }
+    }
+    if (found) {
+        hits++;
+    } else if (capacity > 0) {
+        misses++;
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return found;
+}
+
+int64_t* PlaintextCache::create(uint32_t* handle) {
+    sgx_thread_mutex_lock(&lock);
+    uint32_t index = firstFree();
+    if (index == PLAINTEXT_MAX_ENTRIES && evictOldest()) index = firstFree();
+
+    int64_t* coeffs = NULL;
+    if (index < PLAINTEXT_MAX_ENTRIES && polyWords > 0) {
+        coeffs = (int64_t*)malloc(polyWords * sizeof(int64_t));
+        if (coeffs != NULL) {
+            memStatsHeapAlloc(polyWords * sizeof(int64_t));
+            Entry& entry = entries[index];
+            entry.coeffs = coeffs;
+            entry.held = 1;
+            entry.users = 0;
+            entry.hasDigest = false;
+            entry.state = PLAINTEXT_ENCODING;
+            *handle = handleOf(index);
+        }
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return coeffs;
+}
+
+void PlaintextCache::publish(uint32_t handle, const uint8_t* digest, bool ok) {
+    sgx_thread_mutex_lock(&lock);
+    Entry* entry = find(handle);
+    if (entry != NULL && entry->state == PLAINTEXT_ENCODING) {
+        if (ok) {
+            entry->state = PLAINTEXT_READY;
+            entry->hasDigest = (digest != NULL);
+            if (digest != NULL) memcpy(entry->digest, digest, PLAINTEXT_DIGEST_BYTES);
+        } else {
+            freeEntry(*entry);
+        }
+    }
+    sgx_thread_mutex_unlock(&lock);
+}
+
+bool PlaintextCache::release(uint32_t handle) {
+    sgx_thread_mutex_lock(&lock);
+    Entry* entry = find(handle);
+    const bool ok = (entry != NULL && entry->state == PLAINTEXT_READY && entry->held > 0);
+    if (ok) {
+        entry->held--;
+        if (entry->held == 0 && entry->users == 0) unused(*entry);
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return ok;
+}
+
+const int64_t* PlaintextCache::get(uint32_t handle) {
+    sgx_thread_mutex_lock(&lock);
+    Entry* entry = find(handle);
+    const int64_t* coeffs = NULL;
+    if (entry != NULL && entry->state == PLAINTEXT_READY && entry->held > 0) {
+        entry->users++;
+        coeffs = entry->coeffs;
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return coeffs;
+}
+
+void PlaintextCache::put(uint32_t handle) {
+    sgx_thread_mutex_lock(&lock);
+    Entry* entry = find(handle);
+    if (entry != NULL && entry->users > 0) {
+        entry->users--;
+        if (entry->held == 0 && entry->users == 0) unused(*entry);
+    }
+    sgx_thread_mutex_unlock(&lock);
+}
+
+void PlaintextCache::getStats(uint64_t* outHits, uint64_t* outMisses, uint64_t* outEvictions, uint32_t* outCached) {
+    sgx_thread_mutex_lock(&lock);
+    *outHits = hits;
+    *outMisses = misses;
+    *outEvictions = evictions;
+    *outCached = cached;
+    sgx_thread_mutex_unlock(&lock);
+}
@@ -0,0 +1,87 @@
+// PlaintextCache.h - Encoded plaintexts held in the enclave by handle, with
+// an LRU cache keyed by message digest
+#ifndef _PLAINTEXT_CACHE_H_
+#define _PLAINTEXT_CACHE_H_
+
+#include "Platform.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Plaintexts per context, held by the host or cached
+#define PLAINTEXT_MAX_ENTRIES 256
+#define PLAINTEXT_DIGEST_BYTES 32
+
+// An entry holds one message encoded into N coefficients at the context
+// scale. The host holds it through the handle ecall_encode returned until
+// it releases it. An entry nobody holds stays cached while the capacity
+// allows, and a later encode or encrypt of a message with the same digest
+// reuses it instead of encoding again. Past the capacity, the least
+// recently released entry is dropped.
+//
+// Encoding and reading happen under the context's read lock; reset()
+// needs its write lock.
+class PlaintextCache {
+private:
+    typedef struct {
+        int64_t* coeffs;                // polyWords, NULL while the entry is free
+        uint8_t digest[PLAINTEXT_DIGEST_BYTES];
+        uint32_t generation;
+        uint32_t held;                  // handles the host has not released
+        uint32_t users;                 // operations reading the coefficients
+        uint64_t lastUse;
+        uint8_t state;
+        bool hasDigest;                 // false for entries encoded without the cache
+    } Entry;
+
+    Entry entries[PLAINTEXT_MAX_ENTRIES];
+    size_t polyWords;
+    uint32_t capacity;                  // unheld entries kept; 0 disables the cache
+    uint32_t cached;
+    uint64_t tick;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    sgx_thread_mutex_t lock;
+
+    PlaintextCache(const PlaintextCache&);
+    PlaintextCache& operator=(const PlaintextCache&);
+
+    uint32_t handleOf(uint32_t index) const { return (entries[index].generation << 16) | (index + 1); }
+    Entry* find(uint32_t handle);
+    uint32_t firstFree() const;
+    void freeEntry(Entry& entry);
+    bool evictOldest();
+    void unused(Entry& entry);
+
+public:
+    PlaintextCache();
+    ~PlaintextCache();
+
+    // Drops every entry and sizes new ones for N = polyWords; 0 frees all
+    void reset(size_t polyWords);
+    // Entries kept once unheld, at most PLAINTEXT_MAX_ENTRIES; a smaller
+    // capacity evicts at once. Clears the counters.
+    sgx_status_t configure(uint32_t capacity);
+    bool caching();
+
+    // A held handle to the ready entry with `digest` (a hit), or false (a
+    // miss). Only counts while the cache is enabled.
+    bool acquire(const uint8_t* digest, uint32_t* handle);
+    // Coefficients of a new held entry to encode into, evicting the
+    // oldest cached entry if every one is taken; NULL when all are held.
+    // publish() makes it usable once encoded (digest may be NULL), or
+    // frees it if encoding failed.
+    int64_t* create(uint32_t* handle);
+    void publish(uint32_t handle, const uint8_t* digest, bool ok);
+    // Releases one of the host's holds; false for an unknown handle
+    bool release(uint32_t handle);
+
+    // Pins the coefficients of a held entry for one operation; NULL for a
+    // stale or unknown handle. Every get() is followed by put().
+    const int64_t* get(uint32_t handle);
+    void put(uint32_t handle);
+
+    void getStats(uint64_t* hits, uint64_t* misses, uint64_t* evictions, uint32_t* cached);
+};
+
+#endif // _PLAINTEXT_CACHE_H_
@@ -0,0 +1,100 @@
+// Platform.h - The SGX runtime services the CKKS core uses: status codes,
+// randomness, mutexes, condition variables and CPU feature queries. Inside
+// the enclave these are the trusted runtime's; with CKKS_NATIVE (the
+// ckks_native build) they map onto the host OS so the same sources run as
+// a plain process.
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef CKKS_NATIVE
+
+#include "sgx_error.h"
+#include "sgx_trts.h"
+#include "sgx_thread.h"
+#include "sgx_cpuid.h"
+#include "sgx_utils.h"
+
+// XFRM the enclave was launched with; register state outside it must not
+// be used
+static inline uint64_t platformXfrm() {
+    const sgx_report_t* report = sgx_self_report();
+    return (report != NULL) ? report->body.attributes.xfrm : 0;
+}
+
+#else
+
+#include <errno.h>
+#include <pthread.h>
+#include <cpuid.h>
+#include <sys/random.h>
+
+// Same values as sgx_error.h, so status codes read alike in both builds
+typedef enum {
+    SGX_SUCCESS = 0x0000,
+    SGX_ERROR_UNEXPECTED = 0x0001,
+    SGX_ERROR_INVALID_PARAMETER = 0x0002,
+    SGX_ERROR_OUT_OF_MEMORY = 0x0003,
+    SGX_ERROR_INVALID_STATE = 0x0005,
+    SGX_ERROR_FEATURE_NOT_SUPPORTED = 0x0008
+} sgx_status_t;
+
+// Kernel CSPRNG in place of RDRAND
+static inline sgx_status_t sgx_read_rand(unsigned char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t got = getrandom(buf, len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return SGX_ERROR_UNEXPECTED;
+        buf += got;
+        len -= (size_t)got;
+    }
+    return SGX_SUCCESS;
+}
+
+typedef pthread_mutex_t sgx_thread_mutex_t;
+typedef pthread_mutexattr_t sgx_thread_mutexattr_t;
+#define SGX_THREAD_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+static inline int sgx_thread_mutex_init(sgx_thread_mutex_t* m, const sgx_thread_mutexattr_t* attr) {
+    return pthread_mutex_init(m, attr);
+}
+static inline int sgx_thread_mutex_destroy(sgx_thread_mutex_t* m) { return pthread_mutex_destroy(m); }
+static inline int sgx_thread_mutex_lock(sgx_thread_mutex_t* m) { return pthread_mutex_lock(m); }
+static inline int sgx_thread_mutex_unlock(sgx_thread_mutex_t* m) { return pthread_mutex_unlock(m); }
+
+typedef pthread_cond_t sgx_thread_cond_t;
+typedef pthread_condattr_t sgx_thread_condattr_t;
+
+static inline int sgx_thread_cond_init(sgx_thread_cond_t* c, const sgx_thread_condattr_t* attr) {
+    return pthread_cond_init(c, attr);
+}
+static inline int sgx_thread_cond_destroy(sgx_thread_cond_t* c) { return pthread_cond_destroy(c); }
+static inline int sgx_thread_cond_wait(sgx_thread_cond_t* c, sgx_thread_mutex_t* m) { return pthread_cond_wait(c, m); }
+static inline int sgx_thread_cond_signal(sgx_thread_cond_t* c) { return pthread_cond_signal(c); }
+static inline int sgx_thread_cond_broadcast(sgx_thread_cond_t* c) { return pthread_cond_broadcast(c); }
+
+static inline sgx_status_t sgx_cpuidex(int cpuinfo[4], int leaf, int subleaf) {
+    if ((unsigned int)leaf > __get_cpuid_max(0, NULL)) return SGX_ERROR_INVALID_PARAMETER;
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    cpuinfo[0] = (int)a;
+    cpuinfo[1] = (int)b;
+    cpuinfo[2] = (int)c;
+    cpuinfo[3] = (int)d;
+    return SGX_SUCCESS;
+}
+
+// XCR0, i.e. the register state the OS saves; 0 without OSXSAVE
+static inline uint64_t platformXfrm() {
+    unsigned int a, b, c, d;
+    if (!__get_cpuid(1, &a, &b, &c, &d) || (c & (1u << 27)) == 0) return 0;
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#endif // CKKS_NATIVE
+
+#endif // _PLATFORM_H_
@@ -0,0 +1,189 @@
+#include "Sampler.h"
+#include "PhaseStats.h"
+#include <string.h>
+#include <math.h>
+
+#define ROTL32(v, c) (((v) << (c)) | ((v) >> (32 - (c))))
+
+#define QUARTER_ROUND(a, b, c, d) \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d, 8);  \
+    c += d; b ^= c; b = ROTL32(b, 7);
+
+static inline uint32_t load32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Computes `blocks` consecutive ChaCha20 blocks. The state is kept
+// lane-major (x[word][block]) so every quarter round operates on all blocks
+// at once and the compiler can keep the lanes in vector registers.
+static void chachaBlocks(const uint32_t key[8], uint64_t nonce, uint64_t counter,
+                         uint8_t* out, uint32_t blocks) {
+    static const uint32_t sigma[4] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    uint32_t init[16][PRNG_BUFFER_BLOCKS];
+    uint32_t x[16][PRNG_BUFFER_BLOCKS];
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (uint32_t w = 0; w < 4; w++) init[w][b] = sigma[w];
+        for (uint32_t w = 0; w < 8; w++) init[4 + w][b] = key[w];
+        uint64_t ctr = counter + b;
+        init[12][b] = (uint32_t)ctr;
+        init[13][b] = (uint32_t)(ctr >> 32);
+        init[14][b] = (uint32_t)nonce;
+        init[15][b] = (uint32_t)(nonce >> 32);
+    }
+    memcpy(x, init, sizeof(x));
+
+    for (uint32_t round = 0; round < 10; round++) {
+        for (uint32_t b = 0; b < PRNG_BUFFER_BLOCKS; b++) {
+            QUARTER_ROUND(x[0][b], x[4][b], x[8][b], x[12][b]);
+            QUARTER_ROUND(x[1][b], x[5][b], x[9][b], x[13][b]);
+            QUARTER_ROUND(x[2][b], x[6][b], x[10][b], x[14][b]);
+            QUARTER_ROUND(x[3][b], x[7][b], x[11][b], x[15][b]);
+            QUARTER_ROUND(x[0][b], x[5][b], x[10][b], x[15][b]);
+            QUARTER_ROUND(x[1][b], x[6][b], x[11][b], x[12][b]);
+            QUARTER_ROUND(x[2][b], x[7][b], x[8][b], x[13][b]);
+            QUARTER_ROUND(x[3][b], x[4][b], x[9][b], x[14][b]);
+        }
+    }
+
+    for (uint32_t b = 0; b < blocks; b++) {
+        for (uint32_t w = 0; w < 16; w++) {
+            uint32_t v = x[w][b] + init[w][b];
+            uint8_t* p = out + 64 * b + 4 * w;
+            p[0] = (uint8_t)v;
+            p[1] = (uint8_t)(v >> 8);
+            p[2] = (uint8_t)(v >> 16);
+            p[3] = (uint8_t)(v >> 24);
+        }
+    }
+}
+
+ChaCha20Prng::ChaCha20Prng() : nonce(0), counter(0), bufferPos(sizeof(buffer)) {
+    memset(key, 0, sizeof(key));
+}
+
+ChaCha20Prng::~ChaCha20Prng() {
+    memset(key, 0, sizeof(key));
+    memset(buffer, 0, sizeof(buffer));
+}
+
+void ChaCha20Prng::seed(const uint8_t seedBytes[PRNG_SEED_BYTES], uint64_t streamNonce) {
+    for (uint32_t w = 0; w < 8; w++) {
+        key[w] = load32(seedBytes + 4 * w);
+    }
+    nonce = streamNonce;
+    counter = 0;
+    bufferPos = sizeof(buffer);
+}
+
+void ChaCha20Prng::refill() {
+    chachaBlocks(key, nonce, counter, buffer, PRNG_BUFFER_BLOCKS);
+    counter += PRNG_BUFFER_BLOCKS;
+    bufferPos = 0;
+}
+
+void ChaCha20Prng::generate(uint8_t* out, size_t len) {
+    // Drain the buffered keystream first, then write whole chunks directly
+    size_t avail = sizeof(buffer) - bufferPos;
+    size_t take = (len < avail) ? len : avail;
+    memcpy(out, buffer + bufferPos, take);
+    bufferPos += (uint32_t)take;
+    out += take;
+    len -= take;
+
+    while (len >= sizeof(buffer)) {
+        chachaBlocks(key, nonce, counter, out, PRNG_BUFFER_BLOCKS);
+        counter += PRNG_BUFFER_BLOCKS;
+        out += sizeof(buffer);
+        len -= sizeof(buffer);
+    }
+
+    if (len > 0) {
+        refill();
+        memcpy(out, buffer, len);
+        bufferPos = (uint32_t)len;
+    }
+}
+
+void ChaCha20Prng::generateUniform(uint64_t* out, uint32_t n, const Modulus& q) {
+    PHASE_SCOPE(CKKS_PHASE_SAMPLE);
+    // Rejection sampling against the bit width of q. The output is public
+    // (the 'a' polynomial), so the data-dependent retry is acceptable.
+    uint64_t mask = 1;
+    while (mask < q.value()) mask = (mask << 1) | 1;
+
+    generate((uint8_t*)out, n * sizeof(uint64_t));
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t v = out[i] & mask;
+        while (v >= q.value()) {
+            generate((uint8_t*)&v, sizeof(v));
+            v &= mask;
+        }
+        out[i] = v;
+    }
+}
+
+Sampler::Sampler() {
+    // Cumulative distribution of |x| for the tail-cut discrete Gaussian,
+    // scaled to 63 bits. Built once per sampler; sampling itself does no
+    // float math.
+    double rho[GAUSSIAN_TAIL];
+    double total = 0.0;
+    for (uint32_t k = 0; k < GAUSSIAN_TAIL; k++) {
+        rho[k] = exp(-(double)(k * k) / (2.0 * GAUSSIAN_SIGMA * GAUSSIAN_SIGMA));
+        total += (k == 0) ? rho[k] : 2.0 * rho[k];
+    }
+
+    double cumulative = 0.0;
+    for (uint32_t k = 0; k < GAUSSIAN_TAIL; k++) {
+        cumulative += ((k == 0) ? rho[k] : 2.0 * rho[k]) / total;
+        double scaled = ldexp(cumulative, 63);
+        cdt[k] = (scaled >= ldexp(1.0, 63)) ? (1ULL << 63) : (uint64_t)scaled;
+    }
+    cdt[GAUSSIAN_TAIL - 1] = 1ULL << 63;
+}
+
+sgx_status_t Sampler::init() {
+    uint8_t seedBytes[PRNG_SEED_BYTES];
+    sgx_status_t status = sgx_read_rand(seedBytes, sizeof(seedBytes));
+    if (status != SGX_SUCCESS) return status;
+
+    prng.seed(seedBytes, 0);
+    memset(seedBytes, 0, sizeof(seedBytes));
+    return SGX_SUCCESS;
+}
+
+void Sampler::sampleTernary(int64_t* out, uint32_t n) {
+    PHASE_SCOPE(CKKS_PHASE_SAMPLE);
+    prng.generate((uint8_t*)out, n * sizeof(int64_t));
+
+    // floor(r * 3 / 2^64) is uniform on {0, 1, 2} up to a 2^-64 bias,
+    // unlike the byte % 3 it replaces
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t r = (uint64_t)out[i];
+        out[i] = (int64_t)mulHi64(r, 3) - 1;
+    }
+}
+
+void Sampler::sampleGaussian(int64_t* out, uint32_t n) {
+    PHASE_SCOPE(CKKS_PHASE_SAMPLE);
+    prng.generate((uint8_t*)out, n * sizeof(int64_t));
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t r = (uint64_t)out[i];
+        uint64_t u = r >> 1;
+        uint64_t sign = r & 1;
+
+        // Scan the whole table so the running time does not depend on |x|
+        uint64_t magnitude = 0;
+        for (uint32_t k = 0; k < GAUSSIAN_TAIL; k++) {
+            magnitude += ((cdt[k] - u - 1) >> 63);
+        }
+
+        // sign ? -magnitude : magnitude
+        uint64_t value = (magnitude ^ (0 - sign)) + sign;
+        out[i] = (int64_t)value;
+    }
+}
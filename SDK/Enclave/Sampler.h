@@ -0,0 +1,63 @@
+// Sampler.h - ChaCha20-based CSPRNG and bulk polynomial samplers
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+#include "Platform.h"
+#include "Modulus.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define PRNG_SEED_BYTES 32
+#define PRNG_BUFFER_BLOCKS 8
+
+// Standard deviation and tail cut of the discrete Gaussian error
+#define GAUSSIAN_SIGMA 3.19
+#define GAUSSIAN_TAIL 20
+
+// ChaCha20 keystream generator. The 32-byte seed is the ChaCha20 key; the
+// 64-bit block counter never wraps in practice, so one seed serves the
+// lifetime of a sampler.
+class ChaCha20Prng {
+private:
+    uint32_t key[8];
+    uint64_t nonce;
+    uint64_t counter;
+    uint8_t buffer[PRNG_BUFFER_BLOCKS * 64];
+    uint32_t bufferPos;
+
+    void refill();
+
+public:
+    ChaCha20Prng();
+    ~ChaCha20Prng();
+
+    void seed(const uint8_t seedBytes[PRNG_SEED_BYTES], uint64_t streamNonce);
+    void generate(uint8_t* out, size_t len);
+    // Uniform over [0, q); also expands public polynomials from a seed
+    void generateUniform(uint64_t* out, uint32_t n, const Modulus& q);
+};
+
+// Fills whole polynomials from one keystream pass. Ternary and Gaussian
+// sampling are branch-free in the sampled values.
+class Sampler {
+private:
+    ChaCha20Prng prng;
+    uint64_t cdt[GAUSSIAN_TAIL];    // 2^63 * P(|x| <= k) for k < GAUSSIAN_TAIL
+
+public:
+    Sampler();
+
+    // Seeds from the hardware RNG (sgx_read_rand)
+    sgx_status_t init();
+
+    void generate(uint8_t* out, size_t len) { prng.generate(out, len); }
+
+    // Uniform over {-1, 0, 1}
+    void sampleTernary(int64_t* out, uint32_t n);
+    // Discrete Gaussian with standard deviation GAUSSIAN_SIGMA
+    void sampleGaussian(int64_t* out, uint32_t n);
+    // Uniform over [0, q)
+    void sampleUniform(uint64_t* out, uint32_t n, const Modulus& q) { prng.generateUniform(out, n, q); }
+};
+
+#endif // _SAMPLER_H_
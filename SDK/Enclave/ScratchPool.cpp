@@ -0,0 +1,74 @@
+#include "ScratchPool.h"
+#include "MemStats.h"
+
+ScratchPool::ScratchPool() : workspaceBytes(0) {
+    for (uint32_t i = 0; i < CKKS_MAX_THREADS; i++) {
+        slots[i] = NULL;
+        busy[i] = false;
+    }
+    sgx_thread_mutex_init(&lock, NULL);
+}
+
+ScratchPool::~ScratchPool() {
+    for (uint32_t i = 0; i < CKKS_MAX_THREADS; i++) {
+        if (slots[i] != NULL) {
+            delete slots[i];
+            memStatsHeapFree(sizeof(Scratch));
+        }
+    }
+    sgx_thread_mutex_destroy(&lock);
+}
+
+void ScratchPool::init(size_t bytes) {
+    workspaceBytes = bytes;
+}
+
+Scratch* ScratchPool::acquire() {
+    sgx_thread_mutex_lock(&lock);
+
+    // Prefer a slot that already exists; remember the first empty one
+    uint32_t empty = CKKS_MAX_THREADS;
+    for (uint32_t i = 0; i < CKKS_MAX_THREADS; i++) {
+        if (slots[i] != NULL && !busy[i]) {
+            busy[i] = true;
+            sgx_thread_mutex_unlock(&lock);
+            return slots[i];
+        }
+        if (slots[i] == NULL && !busy[i] && empty == CKKS_MAX_THREADS) empty = i;
+    }
+    if (empty == CKKS_MAX_THREADS) {
+        sgx_thread_mutex_unlock(&lock);
+        return NULL;
+    }
+
+    // Reserve the slot, then seed and allocate it outside the lock
+    busy[empty] = true;
+    sgx_thread_mutex_unlock(&lock);
+
+    Scratch* scratch = new Scratch;
+    if (scratch != NULL) {
+        memStatsHeapAlloc(sizeof(Scratch));
+        if (scratch->sampler.init() != SGX_SUCCESS || !scratch->workspace.init(workspaceBytes)) {
+            delete scratch;
+            memStatsHeapFree(sizeof(Scratch));
+            scratch = NULL;
+        }
+    }
+
+    sgx_thread_mutex_lock(&lock);
+    slots[empty] = scratch;
+    busy[empty] = (scratch != NULL);
+    sgx_thread_mutex_unlock(&lock);
+    return scratch;
+}
+
+void ScratchPool::release(Scratch* scratch) {
+    sgx_thread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < CKKS_MAX_THREADS; i++) {
+        if (slots[i] == scratch) {
+            busy[i] = false;
+            break;
+        }
+    }
+    sgx_thread_mutex_unlock(&lock);
+}
@@ -0,0 +1,64 @@
+// ScratchPool.h - Per-thread sampler and workspace state for concurrent ecalls
+#ifndef _SCRATCH_POOL_H_
+#define _SCRATCH_POOL_H_
+
+#include "Sampler.h"
+#include "Workspace.h"
+#include "Platform.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Upper bound on concurrent operations per context. Matches the TCS count
+// the enclave is signed with (ENCLAVE_TCS in the Makefile), since every
+// in-flight ecall occupies one TCS.
+#ifndef CKKS_MAX_THREADS
+#define CKKS_MAX_THREADS 16
+#endif
+
+// Mutable state an operation needs for itself: its own keystream and its
+// own scratch arena. Keys and tables stay shared and read-only.
+typedef struct {
+    Sampler sampler;
+    Workspace workspace;
+} Scratch;
+
+// Slots are created on first use so a single-threaded run pays for one.
+// acquire() returns NULL when every slot is busy or a new slot cannot be
+// seeded or allocated.
+class ScratchPool {
+private:
+    Scratch* slots[CKKS_MAX_THREADS];
+    bool busy[CKKS_MAX_THREADS];
+    size_t workspaceBytes;
+    sgx_thread_mutex_t lock;
+
+    ScratchPool(const ScratchPool&);
+    ScratchPool& operator=(const ScratchPool&);
+
+public:
+    ScratchPool();
+    ~ScratchPool();
+
+    void init(size_t workspaceBytes);
+
+    Scratch* acquire();
+    void release(Scratch* scratch);
+};
+
+// Holds a slot for the lifetime of one operation
+class ScratchLease {
+private:
+    ScratchPool& pool;
+    Scratch* scratch;
+
+    ScratchLease(const ScratchLease&);
+    ScratchLease& operator=(const ScratchLease&);
+
+public:
+    explicit ScratchLease(ScratchPool& p) : pool(p), scratch(p.acquire()) {}
+    ~ScratchLease() { if (scratch != NULL) pool.release(scratch); }
+
+    Scratch* get() const { return scratch; }
+};
+
+#endif // _SCRATCH_POOL_H_
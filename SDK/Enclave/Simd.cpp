@@ -0,0 +1,337 @@
+#include "Simd.h"
+#include "Platform.h"
+#include <string.h>
+#include <math.h>
+
+// Scalar kernels: the reference every vector variant must match
+
+static void scalarAddMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = mod.add(a[i], b[i]);
+    }
+}
+
+static void scalarSubMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = mod.sub(a[i], b[i]);
+    }
+}
+
+static void scalarMulMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = mod.mul(a[i], b[i]);
+    }
+}
+
+static void scalarMulAddMod(const uint64_t* a, const uint64_t* b, uint64_t* acc, uint32_t n,
+                            const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        acc[i] = mod.add(acc[i], mod.mul(a[i], b[i]));
+    }
+}
+
+static void scalarMulScalarMod(const uint64_t* a, uint64_t w, uint64_t wShoup, uint64_t* out, uint32_t n,
+                               const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = mod.mulShoup(a[i], w, wShoup);
+    }
+}
+
+static void scalarReduceSigned(const int64_t* a, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = mod.reduceSigned(a[i]);
+    }
+}
+
+static void scalarNttForwardStage(uint64_t* a, uint32_t m, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                  const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < m; i++) {
+        const uint64_t wi = w[m + i];
+        const uint64_t wiShoup = wShoup[m + i];
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j++) {
+            uint64_t u = x[j];
+            uint64_t v = mod.mulShoup(y[j], wi, wiShoup);
+            x[j] = mod.add(u, v);
+            y[j] = mod.sub(u, v);
+        }
+    }
+}
+
+static void scalarNttInverseStage(uint64_t* a, uint32_t h, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                  const ModulusWords& q) {
+    const Modulus mod(q);
+    for (uint32_t i = 0; i < h; i++) {
+        const uint64_t wi = w[h + i];
+        const uint64_t wiShoup = wShoup[h + i];
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j++) {
+            uint64_t u = x[j];
+            uint64_t v = y[j];
+            x[j] = mod.add(u, v);
+            y[j] = mod.mulShoup(mod.sub(u, v), wi, wiShoup);
+        }
+    }
+}
+
+static void scalarFftForwardStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        for (uint32_t j = 0; j < lenh; j++) {
+            complex_t u = vals[i + j];
+            complex_t v = vals[i + j + lenh];
+            complex_t t;
+            t.real = v.real * w[j].real - v.imag * w[j].imag;
+            t.imag = v.real * w[j].imag + v.imag * w[j].real;
+
+            vals[i + j].real = u.real + t.real;
+            vals[i + j].imag = u.imag + t.imag;
+            vals[i + j + lenh].real = u.real - t.real;
+            vals[i + j + lenh].imag = u.imag - t.imag;
+        }
+    }
+}
+
+static void scalarFftInverseStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        for (uint32_t j = 0; j < lenh; j++) {
+            complex_t u = vals[i + j];
+            complex_t v = vals[i + j + lenh];
+
+            vals[i + j].real = u.real + v.real;
+            vals[i + j].imag = u.imag + v.imag;
+
+            double dr = u.real - v.real;
+            double di = u.imag - v.imag;
+            vals[i + j + lenh].real = dr * w[j].real - di * w[j].imag;
+            vals[i + j + lenh].imag = dr * w[j].imag + di * w[j].real;
+        }
+    }
+}
+
+static bool scalarSlotsToCoeffs(const complex_t* vals, uint32_t count, double scale, double bound,
+                                int64_t* real, int64_t* imag) {
+    for (uint32_t i = 0; i < count; i++) {
+        double re = round(vals[i].real * scale);
+        double im = round(vals[i].imag * scale);
+        if (!(fabs(re) < bound) || !(fabs(im) < bound)) return false;
+        real[i] = (int64_t)re;
+        imag[i] = (int64_t)im;
+    }
+    return true;
+}
+
+static void scalarCoeffsToSlots(const int64_t* real, const int64_t* imag, uint32_t count, double scale,
+                                complex_t* vals) {
+    for (uint32_t i = 0; i < count; i++) {
+        vals[i].real = (double)real[i] / scale;
+        vals[i].imag = (double)imag[i] / scale;
+    }
+}
+
+const SimdKernels g_simdScalar = {
+    "scalar",
+    scalarAddMod, scalarSubMod, scalarMulMod, scalarMulAddMod, scalarMulScalarMod, scalarReduceSigned,
+    scalarNttForwardStage, scalarNttInverseStage,
+    scalarFftForwardStage, scalarFftInverseStage,
+    scalarSlotsToCoeffs, scalarCoeffsToSlots
+};
+
+static const SimdKernels* const g_simdLevels[3] = {&g_simdScalar, &g_simdAvx2, &g_simdAvx512};
+static uint32_t g_simdLevel = SIMD_SCALAR;
+
+const SimdKernels& simdKernels() {
+    return *g_simdLevels[g_simdLevel];
+}
+
+uint32_t simdLevel() {
+    return g_simdLevel;
+}
+
+// Self-check
+
+#define CHECK_N 64          // a few vector widths plus room for the tail
+#define CHECK_TAIL 61       // odd length for the element-wise kernels
+
+static uint64_t nextRandom(uint64_t* state) {
+    // xorshift64*: fixed, reproducible inputs
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static bool sameWords(const void* a, const void* b, size_t bytes) {
+    return memcmp(a, b, bytes) == 0;
+}
+
+static bool checkModular(const SimdKernels& k, const Modulus& mod, uint64_t* state) {
+    const ModulusWords q = mod.words();
+    uint64_t a[CHECK_N], b[CHECK_N], w[CHECK_N], wShoup[CHECK_N];
+    uint64_t expected[CHECK_N], actual[CHECK_N];
+    int64_t s[CHECK_N];
+
+    for (uint32_t i = 0; i < CHECK_N; i++) {
+        a[i] = mod.reduce(nextRandom(state));
+        b[i] = mod.reduce(nextRandom(state));
+        w[i] = mod.reduce(nextRandom(state));
+        wShoup[i] = mod.shoup(w[i]);
+        s[i] = (int64_t)nextRandom(state);
+    }
+    // Edge values: 0, q - 1 and the extreme signed words
+    a[0] = 0;
+    b[1] = mod.value() - 1;
+    a[2] = b[2] = mod.value() - 1;
+    s[0] = 0;
+    s[1] = INT64_MIN;
+    s[2] = INT64_MAX;
+    s[3] = -(int64_t)mod.value();
+
+    g_simdScalar.addMod(a, b, expected, CHECK_TAIL, q);
+    k.addMod(a, b, actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    g_simdScalar.subMod(a, b, expected, CHECK_TAIL, q);
+    k.subMod(a, b, actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    g_simdScalar.mulMod(a, b, expected, CHECK_TAIL, q);
+    k.mulMod(a, b, actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    memcpy(expected, w, sizeof(w));
+    memcpy(actual, w, sizeof(w));
+    g_simdScalar.mulAddMod(a, b, expected, CHECK_TAIL, q);
+    k.mulAddMod(a, b, actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    g_simdScalar.mulScalarMod(a, w[5], wShoup[5], expected, CHECK_TAIL, q);
+    k.mulScalarMod(a, w[5], wShoup[5], actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    g_simdScalar.reduceSigned(s, expected, CHECK_TAIL, q);
+    k.reduceSigned(s, actual, CHECK_TAIL, q);
+    if (!sameWords(expected, actual, CHECK_TAIL * sizeof(uint64_t))) return false;
+
+    // Every layer of a full transform; the twiddles need not be roots of
+    // unity for the arithmetic to be compared
+    memcpy(expected, a, sizeof(a));
+    memcpy(actual, a, sizeof(a));
+    for (uint32_t m = 1, t = CHECK_N / 2; m < CHECK_N; m <<= 1, t >>= 1) {
+        g_simdScalar.nttForwardStage(expected, m, t, w, wShoup, q);
+        k.nttForwardStage(actual, m, t, w, wShoup, q);
+    }
+    if (!sameWords(expected, actual, sizeof(expected))) return false;
+
+    for (uint32_t h = CHECK_N / 2, t = 1; h >= 1; h >>= 1, t <<= 1) {
+        g_simdScalar.nttInverseStage(expected, h, t, w, wShoup, q);
+        k.nttInverseStage(actual, h, t, w, wShoup, q);
+    }
+    return sameWords(expected, actual, sizeof(expected));
+}
+
+static double randomUnit(uint64_t* state) {
+    // Uniform in [-1, 1) with 53 random bits
+    return (double)(int64_t)nextRandom(state) * (1.0 / 9223372036854775808.0);
+}
+
+static bool checkSlots(const SimdKernels& k, uint64_t* state) {
+    const uint32_t slots = CHECK_N / 2;
+    complex_t vals[CHECK_N / 2], expected[CHECK_N / 2], actual[CHECK_N / 2], w[CHECK_N / 2];
+    int64_t real[2][CHECK_N / 2], imag[2][CHECK_N / 2];
+
+    for (uint32_t i = 0; i < slots; i++) {
+        vals[i].real = randomUnit(state) * 1000.0;
+        vals[i].imag = randomUnit(state) * 1000.0;
+        w[i].real = randomUnit(state);
+        w[i].imag = randomUnit(state);
+    }
+
+    memcpy(expected, vals, sizeof(vals));
+    memcpy(actual, vals, sizeof(vals));
+    for (uint32_t lenh = 1; lenh < slots; lenh <<= 1) {
+        g_simdScalar.fftForwardStage(expected, slots, lenh, w);
+        k.fftForwardStage(actual, slots, lenh, w);
+    }
+    for (uint32_t lenh = slots / 2; lenh >= 1; lenh >>= 1) {
+        g_simdScalar.fftInverseStage(expected, slots, lenh, w);
+        k.fftInverseStage(actual, slots, lenh, w);
+    }
+    if (!sameWords(expected, actual, sizeof(expected))) return false;
+
+    // Rounding ties, negative zero and large magnitudes
+    vals[0].real = 2.5 / 1048576.0;
+    vals[0].imag = -2.5 / 1048576.0;
+    vals[1].real = -0.25 / 1048576.0;
+    vals[1].imag = 1099511627776.0;
+    bool okExpected = g_simdScalar.slotsToCoeffs(vals, CHECK_TAIL / 2, 1048576.0, 1.2e18, real[0], imag[0]);
+    bool okActual = k.slotsToCoeffs(vals, CHECK_TAIL / 2, 1048576.0, 1.2e18, real[1], imag[1]);
+    if (!okExpected || !okActual || !sameWords(real[0], real[1], (CHECK_TAIL / 2) * sizeof(int64_t)) ||
+        !sameWords(imag[0], imag[1], (CHECK_TAIL / 2) * sizeof(int64_t))) {
+        return false;
+    }
+
+    // A value past the bound must be rejected by both
+    vals[7].imag = 2.0e12;
+    if (k.slotsToCoeffs(vals, slots, 1048576.0, 1.2e18, real[1], imag[1])) return false;
+
+    // Full-range words, so the int64 -> double conversion must round correctly
+    for (uint32_t i = 0; i < slots; i++) {
+        real[0][i] = (int64_t)nextRandom(state);
+        imag[0][i] = (int64_t)nextRandom(state) >> (i % 64);
+    }
+    real[0][0] = INT64_MIN;
+    imag[0][0] = INT64_MAX;
+    g_simdScalar.coeffsToSlots(real[0], imag[0], CHECK_TAIL / 2, 1073741824.0, expected);
+    k.coeffsToSlots(real[0], imag[0], CHECK_TAIL / 2, 1073741824.0, actual);
+    return sameWords(expected, actual, (CHECK_TAIL / 2) * sizeof(complex_t));
+}
+
+static bool selfCheck(const SimdKernels& k) {
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    // A 61-bit and a 30-bit modulus; any odd value exercises the reductions
+    return checkModular(k, Modulus((1ULL << 61) - 1), &state) &&
+           checkModular(k, Modulus(1073479681ULL), &state) &&
+           checkSlots(k, &state);
+}
+
+// Highest level the CPU reports and the enclave may use. CPUID is answered
+// by the untrusted host; a false claim can only crash the enclave with #UD.
+// XFRM comes from the enclave's own report (XCR0 in the native build), so
+// AVX state that the enclave was not launched with is never touched.
+static uint32_t detectLevel() {
+    int leaf1[4] = {0, 0, 0, 0};
+    int leaf7[4] = {0, 0, 0, 0};
+    if (sgx_cpuidex(leaf1, 1, 0) != SGX_SUCCESS || sgx_cpuidex(leaf7, 7, 0) != SGX_SUCCESS) {
+        return SIMD_SCALAR;
+    }
+    const uint64_t xfrm = platformXfrm();
+
+    const bool avx = (leaf1[2] & (1 << 28)) != 0 && (xfrm & 0x6) == 0x6;
+    const bool avx2 = avx && (leaf7[1] & (1 << 5)) != 0;
+    const bool avx512 = avx2 && (leaf7[1] & (1 << 16)) != 0 && (leaf7[1] & (1 << 17)) != 0 &&
+                        (xfrm & 0xE0) == 0xE0;
+
+    if (avx512) return SIMD_AVX512;
+    return avx2 ? SIMD_AVX2 : SIMD_SCALAR;
+}
+
+uint32_t simdInit() {
+    uint32_t level = detectLevel();
+    if (level > CKKS_SIMD_MAX_LEVEL) level = CKKS_SIMD_MAX_LEVEL;
+
+    // Fall back one level at a time until a kernel set matches the scalar one
+    while (level > SIMD_SCALAR && !selfCheck(*g_simdLevels[level])) {
+        level--;
+    }
+    g_simdLevel = level;
+    return level;
+}
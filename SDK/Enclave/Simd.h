@@ -0,0 +1,74 @@
+// Simd.h - Vectorized coefficient and slot kernels with runtime dispatch
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include "Modulus.h"
+#include "FFT.h"
+#include <stdint.h>
+
+#define SIMD_SCALAR 0
+#define SIMD_AVX2 1
+#define SIMD_AVX512 2
+
+// Highest kernel set simdInit() may select; -DCKKS_SIMD_MAX_LEVEL=0 pins
+// the scalar kernels, e.g. for a baseline measurement
+#ifndef CKKS_SIMD_MAX_LEVEL
+#define CKKS_SIMD_MAX_LEVEL SIMD_AVX512
+#endif
+
+// One table per instruction set. Every variant produces bit-identical
+// output to the scalar one: the modular kernels reproduce Modulus word for
+// word, and the floating-point kernels perform the same IEEE operations in
+// the same order (the kernel files are built with -ffp-contract=off).
+//
+// Modular inputs are reduced to [0, q) unless noted; outputs may alias
+// inputs. Stage kernels run one butterfly layer of NTTTables / FFTPlan.
+typedef struct {
+    const char* name;
+
+    void (*addMod)(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q);
+    void (*subMod)(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q);
+    void (*mulMod)(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q);
+    // acc += a * b
+    void (*mulAddMod)(const uint64_t* a, const uint64_t* b, uint64_t* acc, uint32_t n, const ModulusWords& q);
+    // out = a * w with the Shoup companion of w; a may be any word
+    void (*mulScalarMod)(const uint64_t* a, uint64_t w, uint64_t wShoup, uint64_t* out, uint32_t n,
+                         const ModulusWords& q);
+    // Signed words (any value) to [0, q)
+    void (*reduceSigned)(const int64_t* a, uint64_t* out, uint32_t n, const ModulusWords& q);
+
+    // Cooley-Tukey layer with m blocks of 2t; twiddle of block i at w[m + i]
+    void (*nttForwardStage)(uint64_t* a, uint32_t m, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                            const ModulusWords& q);
+    // Gentleman-Sande layer with h blocks of 2t; twiddle of block i at w[h + i]
+    void (*nttInverseStage)(uint64_t* a, uint32_t h, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                            const ModulusWords& q);
+
+    // Embedding butterflies over blocks of 2 * lenh slots; w holds the lenh
+    // twiddles of the layer
+    void (*fftForwardStage)(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w);
+    void (*fftInverseStage)(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w);
+
+    // real[i], imag[i] = round(vals[i] * scale) (halves away from zero);
+    // false if any value is not below bound in magnitude. bound <= 2^62.
+    bool (*slotsToCoeffs)(const complex_t* vals, uint32_t count, double scale, double bound,
+                          int64_t* real, int64_t* imag);
+    // vals[i] = (real[i] / scale, imag[i] / scale)
+    void (*coeffsToSlots)(const int64_t* real, const int64_t* imag, uint32_t count, double scale,
+                          complex_t* vals);
+} SimdKernels;
+
+extern const SimdKernels g_simdScalar;
+extern const SimdKernels g_simdAvx2;
+extern const SimdKernels g_simdAvx512;
+
+// Picks the widest kernel set the CPU and the enclave's XSAVE features
+// (XFRM) allow and that passes a bit-exact comparison against the scalar
+// kernels on fixed inputs. Returns the selected SIMD_* level. Until it is
+// called, the scalar kernels are used.
+uint32_t simdInit();
+
+const SimdKernels& simdKernels();
+uint32_t simdLevel();
+
+#endif // _SIMD_H_
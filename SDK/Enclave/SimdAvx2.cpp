@@ -0,0 +1,317 @@
+// AVX2 kernels, four 64-bit lanes. Built with -mavx2; nothing in this file
+// may call inline code shared with the rest of the enclave (such as the
+// Modulus methods), or the linker could keep an AVX2 copy of it.
+#include "Simd.h"
+#include <immintrin.h>
+
+// High 64 bits of the 128-bit lane products, from four 32x32 multiplies
+static inline __m256i mulHi(__m256i a, __m256i b) {
+    const __m256i lowMask = _mm256_set1_epi64x(0xffffffffLL);
+    __m256i aHi = _mm256_srli_epi64(a, 32);
+    __m256i bHi = _mm256_srli_epi64(b, 32);
+    __m256i ll = _mm256_mul_epu32(a, b);
+    __m256i lh = _mm256_mul_epu32(a, bHi);
+    __m256i hl = _mm256_mul_epu32(aHi, b);
+    __m256i hh = _mm256_mul_epu32(aHi, bHi);
+
+    __m256i mid = _mm256_add_epi64(_mm256_srli_epi64(ll, 32), _mm256_and_si256(lh, lowMask));
+    mid = _mm256_add_epi64(mid, _mm256_and_si256(hl, lowMask));
+    __m256i hi = _mm256_add_epi64(hh, _mm256_srli_epi64(lh, 32));
+    hi = _mm256_add_epi64(hi, _mm256_srli_epi64(hl, 32));
+    return _mm256_add_epi64(hi, _mm256_srli_epi64(mid, 32));
+}
+
+// Low 64 bits of the lane products
+static inline __m256i mulLo(__m256i a, __m256i b) {
+    __m256i ll = _mm256_mul_epu32(a, b);
+    __m256i lh = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    __m256i hl = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    return _mm256_add_epi64(ll, _mm256_slli_epi64(_mm256_add_epi64(lh, hl), 32));
+}
+
+// All-ones where a < b as unsigned words
+static inline __m256i lessThan(__m256i a, __m256i b) {
+    const __m256i bias = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(b, bias), _mm256_xor_si256(a, bias));
+}
+
+// Picks a where the sign bit of mask is set, b elsewhere
+static inline __m256i select(__m256i mask, __m256i a, __m256i b) {
+    return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(b), _mm256_castsi256_pd(a),
+                                                 _mm256_castsi256_pd(mask)));
+}
+
+// r >= q ? r - q : r, for r < 2^63
+static inline __m256i reduceOnce(__m256i r, __m256i q) {
+    __m256i d = _mm256_sub_epi64(r, q);
+    return select(d, r, d);
+}
+
+static inline __m256i addMod(__m256i a, __m256i b, __m256i q) {
+    return reduceOnce(_mm256_add_epi64(a, b), q);
+}
+
+static inline __m256i subMod(__m256i a, __m256i b, __m256i q) {
+    __m256i d = _mm256_sub_epi64(a, b);
+    return select(d, _mm256_add_epi64(d, q), d);
+}
+
+static inline __m256i mulShoup(__m256i a, __m256i w, __m256i wShoup, __m256i q) {
+    __m256i r = _mm256_sub_epi64(mulLo(a, w), mulLo(mulHi(a, wShoup), q));
+    return reduceOnce(r, q);
+}
+
+// Modulus::mul: Barrett reduction of the 128-bit product, step for step
+static inline __m256i mulBarrett(__m256i a, __m256i b, __m256i q, __m256i ratioHi, __m256i ratioLo) {
+    const __m256i one = _mm256_set1_epi64x(1);
+    __m256i zHi = mulHi(a, b);
+    __m256i zLo = mulLo(a, b);
+
+    __m256i carry = mulHi(zLo, ratioLo);
+    __m256i lo = mulLo(zLo, ratioHi);
+    __m256i tmp1 = _mm256_add_epi64(lo, carry);
+    __m256i tmp3 = _mm256_add_epi64(mulHi(zLo, ratioHi), _mm256_and_si256(lessThan(tmp1, lo), one));
+
+    lo = mulLo(zHi, ratioLo);
+    __m256i sum = _mm256_add_epi64(lo, tmp1);
+    carry = _mm256_add_epi64(mulHi(zHi, ratioLo), _mm256_and_si256(lessThan(sum, lo), one));
+    __m256i quot = _mm256_add_epi64(_mm256_add_epi64(mulLo(zHi, ratioHi), tmp3), carry);
+
+    return reduceOnce(_mm256_sub_epi64(zLo, mulLo(quot, q)), q);
+}
+
+#define LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define STORE(p, v) _mm256_storeu_si256((__m256i*)(p), (v))
+
+static void avx2AddMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        STORE(out + i, addMod(LOAD(a + i), LOAD(b + i), vq));
+    }
+    g_simdScalar.addMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx2SubMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        STORE(out + i, subMod(LOAD(a + i), LOAD(b + i), vq));
+    }
+    g_simdScalar.subMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx2MulMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    const __m256i ratioHi = _mm256_set1_epi64x((long long)q.ratioHi);
+    const __m256i ratioLo = _mm256_set1_epi64x((long long)q.ratioLo);
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        STORE(out + i, mulBarrett(LOAD(a + i), LOAD(b + i), vq, ratioHi, ratioLo));
+    }
+    g_simdScalar.mulMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx2MulAddMod(const uint64_t* a, const uint64_t* b, uint64_t* acc, uint32_t n, const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    const __m256i ratioHi = _mm256_set1_epi64x((long long)q.ratioHi);
+    const __m256i ratioLo = _mm256_set1_epi64x((long long)q.ratioLo);
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i p = mulBarrett(LOAD(a + i), LOAD(b + i), vq, ratioHi, ratioLo);
+        STORE(acc + i, addMod(LOAD(acc + i), p, vq));
+    }
+    g_simdScalar.mulAddMod(a + i, b + i, acc + i, n - i, q);
+}
+
+static void avx2MulScalarMod(const uint64_t* a, uint64_t w, uint64_t wShoup, uint64_t* out, uint32_t n,
+                             const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    const __m256i vw = _mm256_set1_epi64x((long long)w);
+    const __m256i vwShoup = _mm256_set1_epi64x((long long)wShoup);
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        STORE(out + i, mulShoup(LOAD(a + i), vw, vwShoup, vq));
+    }
+    g_simdScalar.mulScalarMod(a + i, w, wShoup, out + i, n - i, q);
+}
+
+static void avx2ReduceSigned(const int64_t* a, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    const __m256i ratioHi = _mm256_set1_epi64x((long long)q.ratioHi);
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = LOAD(a + i);
+        __m256i sign = _mm256_cmpgt_epi64(zero, x);
+        __m256i magnitude = _mm256_sub_epi64(_mm256_xor_si256(x, sign), sign);
+
+        __m256i r = reduceOnce(_mm256_sub_epi64(magnitude, mulLo(mulHi(magnitude, ratioHi), vq)), vq);
+        __m256i negated = _mm256_andnot_si256(_mm256_cmpeq_epi64(r, zero), _mm256_sub_epi64(vq, r));
+        STORE(out + i, select(sign, negated, r));
+    }
+    g_simdScalar.reduceSigned(a + i, out + i, n - i, q);
+}
+
+static void avx2NttForwardStage(uint64_t* a, uint32_t m, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                const ModulusWords& q) {
+    if (t < 4) {
+        g_simdScalar.nttForwardStage(a, m, t, w, wShoup, q);
+        return;
+    }
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    for (uint32_t i = 0; i < m; i++) {
+        const __m256i wi = _mm256_set1_epi64x((long long)w[m + i]);
+        const __m256i wiShoup = _mm256_set1_epi64x((long long)wShoup[m + i]);
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j += 4) {
+            __m256i u = LOAD(x + j);
+            __m256i v = mulShoup(LOAD(y + j), wi, wiShoup, vq);
+            STORE(x + j, addMod(u, v, vq));
+            STORE(y + j, subMod(u, v, vq));
+        }
+    }
+}
+
+static void avx2NttInverseStage(uint64_t* a, uint32_t h, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                const ModulusWords& q) {
+    if (t < 4) {
+        g_simdScalar.nttInverseStage(a, h, t, w, wShoup, q);
+        return;
+    }
+    const __m256i vq = _mm256_set1_epi64x((long long)q.value);
+    for (uint32_t i = 0; i < h; i++) {
+        const __m256i wi = _mm256_set1_epi64x((long long)w[h + i]);
+        const __m256i wiShoup = _mm256_set1_epi64x((long long)wShoup[h + i]);
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j += 4) {
+            __m256i u = LOAD(x + j);
+            __m256i v = LOAD(y + j);
+            STORE(x + j, addMod(u, v, vq));
+            STORE(y + j, mulShoup(subMod(u, v, vq), wi, wiShoup, vq));
+        }
+    }
+}
+
+// Two interleaved complex values per register: (v.re*w.re - v.im*w.im,
+// v.im*w.re + v.re*w.im), the scalar products in the same order
+static inline __m256d complexMul(__m256d v, __m256d w) {
+    __m256d wReal = _mm256_movedup_pd(w);
+    __m256d wImag = _mm256_permute_pd(w, 0xF);
+    __m256d swapped = _mm256_permute_pd(v, 0x5);
+    return _mm256_addsub_pd(_mm256_mul_pd(v, wReal), _mm256_mul_pd(swapped, wImag));
+}
+
+static void avx2FftForwardStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    if (lenh < 2) {
+        g_simdScalar.fftForwardStage(vals, slots, lenh, w);
+        return;
+    }
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        double* x = (double*)(vals + i);
+        double* y = (double*)(vals + i + lenh);
+        for (uint32_t j = 0; j < lenh; j += 2) {
+            __m256d u = _mm256_loadu_pd(x + 2 * j);
+            __m256d t = complexMul(_mm256_loadu_pd(y + 2 * j), _mm256_loadu_pd((const double*)(w + j)));
+            _mm256_storeu_pd(x + 2 * j, _mm256_add_pd(u, t));
+            _mm256_storeu_pd(y + 2 * j, _mm256_sub_pd(u, t));
+        }
+    }
+}
+
+static void avx2FftInverseStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    if (lenh < 2) {
+        g_simdScalar.fftInverseStage(vals, slots, lenh, w);
+        return;
+    }
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        double* x = (double*)(vals + i);
+        double* y = (double*)(vals + i + lenh);
+        for (uint32_t j = 0; j < lenh; j += 2) {
+            __m256d u = _mm256_loadu_pd(x + 2 * j);
+            __m256d v = _mm256_loadu_pd(y + 2 * j);
+            _mm256_storeu_pd(x + 2 * j, _mm256_add_pd(u, v));
+            _mm256_storeu_pd(y + 2 * j, complexMul(_mm256_sub_pd(u, v), _mm256_loadu_pd((const double*)(w + j))));
+        }
+    }
+}
+
+// round() on integral doubles: truncate, then step away from zero when
+// the dropped fraction is at least one half
+static inline __m256d roundHalfAway(__m256d x) {
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d t = _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256d fraction = _mm256_andnot_pd(signMask, _mm256_sub_pd(x, t));
+    __m256d step = _mm256_or_pd(_mm256_and_pd(signMask, x), _mm256_set1_pd(1.0));
+    __m256d away = _mm256_cmp_pd(fraction, _mm256_set1_pd(0.5), _CMP_GE_OQ);
+    return _mm256_add_pd(t, _mm256_and_pd(away, step));
+}
+
+// Integral doubles below 2^62 in magnitude to int64: split at 2^32 so both
+// halves convert through the 32-bit instruction
+static inline __m256i integralToInt64(__m256d x) {
+    __m256d hi = _mm256_floor_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.0 / 4294967296.0)));
+    __m256d lo = _mm256_sub_pd(x, _mm256_mul_pd(hi, _mm256_set1_pd(4294967296.0)));
+    __m128i hi32 = _mm256_cvttpd_epi32(hi);
+    __m128i lo32 = _mm256_cvttpd_epi32(_mm256_sub_pd(lo, _mm256_set1_pd(2147483648.0)));
+    __m256i result = _mm256_slli_epi64(_mm256_cvtepi32_epi64(hi32), 32);
+    result = _mm256_add_epi64(result, _mm256_cvtepi32_epi64(lo32));
+    return _mm256_add_epi64(result, _mm256_set1_epi64x(2147483648LL));
+}
+
+// Exact int64 to double over the full range, rounding once in the final add
+static inline __m256d int64ToDouble(__m256i x) {
+    __m256i hi = _mm256_srai_epi32(x, 16);
+    hi = _mm256_blend_epi16(hi, _mm256_setzero_si256(), 0x33);
+    hi = _mm256_add_epi64(hi, _mm256_castpd_si256(_mm256_set1_pd(442721857769029238784.0)));      // 3 * 2^67
+    __m256i lo = _mm256_blend_epi16(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)), 0x88); // 2^52
+    __m256d f = _mm256_sub_pd(_mm256_castsi256_pd(hi), _mm256_set1_pd(442726361368656609280.0));  // 3 * 2^67 + 2^52
+    return _mm256_add_pd(f, _mm256_castsi256_pd(lo));
+}
+
+static bool avx2SlotsToCoeffs(const complex_t* vals, uint32_t count, double scale, double bound,
+                              int64_t* real, int64_t* imag) {
+    const __m256d vscale = _mm256_set1_pd(scale);
+    const __m256d vbound = _mm256_set1_pd(bound);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d a = roundHalfAway(_mm256_mul_pd(_mm256_loadu_pd((const double*)(vals + i)), vscale));
+        __m256d b = roundHalfAway(_mm256_mul_pd(_mm256_loadu_pd((const double*)(vals + i + 2)), vscale));
+        __m256d inA = _mm256_cmp_pd(_mm256_andnot_pd(signMask, a), vbound, _CMP_LT_OQ);
+        __m256d inB = _mm256_cmp_pd(_mm256_andnot_pd(signMask, b), vbound, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(_mm256_and_pd(inA, inB)) != 0xF) return false;
+
+        // (r0, i0, r1, i1), (r2, i2, r3, i3) -> (r0, r1, r2, r3), (i0, i1, i2, i3)
+        __m256i wa = integralToInt64(a);
+        __m256i wb = integralToInt64(b);
+        STORE(real + i, _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(wa, wb), 0xD8));
+        STORE(imag + i, _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(wa, wb), 0xD8));
+    }
+    return g_simdScalar.slotsToCoeffs(vals + i, count - i, scale, bound, real + i, imag + i);
+}
+
+static void avx2CoeffsToSlots(const int64_t* real, const int64_t* imag, uint32_t count, double scale,
+                              complex_t* vals) {
+    const __m256d vscale = _mm256_set1_pd(scale);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d re = _mm256_div_pd(int64ToDouble(LOAD(real + i)), vscale);
+        __m256d im = _mm256_div_pd(int64ToDouble(LOAD(imag + i)), vscale);
+        __m256d lo = _mm256_unpacklo_pd(re, im);    // (r0, i0, r2, i2)
+        __m256d hi = _mm256_unpackhi_pd(re, im);    // (r1, i1, r3, i3)
+        _mm256_storeu_pd((double*)(vals + i), _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd((double*)(vals + i + 2), _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+    g_simdScalar.coeffsToSlots(real + i, imag + i, count - i, scale, vals + i);
+}
+
+const SimdKernels g_simdAvx2 = {
+    "avx2",
+    avx2AddMod, avx2SubMod, avx2MulMod, avx2MulAddMod, avx2MulScalarMod, avx2ReduceSigned,
+    avx2NttForwardStage, avx2NttInverseStage,
+    avx2FftForwardStage, avx2FftInverseStage,
+    avx2SlotsToCoeffs, avx2CoeffsToSlots
+};
@@ -0,0 +1,281 @@
+// AVX-512 (F and DQ) kernels, eight 64-bit lanes. Built with -mavx512f
+// -mavx512dq; nothing in this file may call inline code shared with the
+// rest of the enclave (such as the Modulus methods), or the linker could
+// keep an AVX-512 copy of it. Layers too narrow for eight lanes go to the
+// AVX2 kernels.
+#include "Simd.h"
+#include <immintrin.h>
+
+// GCC 12 flags the intentionally undefined pass-through operand the
+// unmasked intrinsics in avx512fintrin.h use (GCC bug 105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// High 64 bits of the 128-bit lane products, from four 32x32 multiplies
+static inline __m512i mulHi(__m512i a, __m512i b) {
+    const __m512i lowMask = _mm512_set1_epi64(0xffffffffLL);
+    __m512i aHi = _mm512_srli_epi64(a, 32);
+    __m512i bHi = _mm512_srli_epi64(b, 32);
+    __m512i ll = _mm512_mul_epu32(a, b);
+    __m512i lh = _mm512_mul_epu32(a, bHi);
+    __m512i hl = _mm512_mul_epu32(aHi, b);
+    __m512i hh = _mm512_mul_epu32(aHi, bHi);
+
+    __m512i mid = _mm512_add_epi64(_mm512_srli_epi64(ll, 32), _mm512_and_si512(lh, lowMask));
+    mid = _mm512_add_epi64(mid, _mm512_and_si512(hl, lowMask));
+    __m512i hi = _mm512_add_epi64(hh, _mm512_srli_epi64(lh, 32));
+    hi = _mm512_add_epi64(hi, _mm512_srli_epi64(hl, 32));
+    return _mm512_add_epi64(hi, _mm512_srli_epi64(mid, 32));
+}
+
+// r >= q ? r - q : r, for r < 2q
+static inline __m512i reduceOnce(__m512i r, __m512i q) {
+    return _mm512_min_epu64(r, _mm512_sub_epi64(r, q));
+}
+
+static inline __m512i addMod(__m512i a, __m512i b, __m512i q) {
+    return reduceOnce(_mm512_add_epi64(a, b), q);
+}
+
+static inline __m512i subMod(__m512i a, __m512i b, __m512i q) {
+    __m512i d = _mm512_sub_epi64(a, b);
+    return _mm512_min_epu64(d, _mm512_add_epi64(d, q));
+}
+
+static inline __m512i mulShoup(__m512i a, __m512i w, __m512i wShoup, __m512i q) {
+    __m512i r = _mm512_sub_epi64(_mm512_mullo_epi64(a, w), _mm512_mullo_epi64(mulHi(a, wShoup), q));
+    return reduceOnce(r, q);
+}
+
+// Modulus::mul: Barrett reduction of the 128-bit product, step for step
+static inline __m512i mulBarrett(__m512i a, __m512i b, __m512i q, __m512i ratioHi, __m512i ratioLo) {
+    const __m512i one = _mm512_set1_epi64(1);
+    __m512i zHi = mulHi(a, b);
+    __m512i zLo = _mm512_mullo_epi64(a, b);
+
+    __m512i carry = mulHi(zLo, ratioLo);
+    __m512i lo = _mm512_mullo_epi64(zLo, ratioHi);
+    __m512i tmp1 = _mm512_add_epi64(lo, carry);
+    __m512i tmp3 = mulHi(zLo, ratioHi);
+    tmp3 = _mm512_mask_add_epi64(tmp3, _mm512_cmplt_epu64_mask(tmp1, lo), tmp3, one);
+
+    lo = _mm512_mullo_epi64(zHi, ratioLo);
+    __m512i sum = _mm512_add_epi64(lo, tmp1);
+    carry = mulHi(zHi, ratioLo);
+    carry = _mm512_mask_add_epi64(carry, _mm512_cmplt_epu64_mask(sum, lo), carry, one);
+    __m512i quot = _mm512_add_epi64(_mm512_add_epi64(_mm512_mullo_epi64(zHi, ratioHi), tmp3), carry);
+
+    return reduceOnce(_mm512_sub_epi64(zLo, _mm512_mullo_epi64(quot, q)), q);
+}
+
+#define LOAD(p) _mm512_loadu_si512((const void*)(p))
+#define STORE(p, v) _mm512_storeu_si512((void*)(p), (v))
+
+static void avx512AddMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        STORE(out + i, addMod(LOAD(a + i), LOAD(b + i), vq));
+    }
+    g_simdScalar.addMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx512SubMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        STORE(out + i, subMod(LOAD(a + i), LOAD(b + i), vq));
+    }
+    g_simdScalar.subMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx512MulMod(const uint64_t* a, const uint64_t* b, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    const __m512i ratioHi = _mm512_set1_epi64((long long)q.ratioHi);
+    const __m512i ratioLo = _mm512_set1_epi64((long long)q.ratioLo);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        STORE(out + i, mulBarrett(LOAD(a + i), LOAD(b + i), vq, ratioHi, ratioLo));
+    }
+    g_simdScalar.mulMod(a + i, b + i, out + i, n - i, q);
+}
+
+static void avx512MulAddMod(const uint64_t* a, const uint64_t* b, uint64_t* acc, uint32_t n,
+                            const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    const __m512i ratioHi = _mm512_set1_epi64((long long)q.ratioHi);
+    const __m512i ratioLo = _mm512_set1_epi64((long long)q.ratioLo);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i p = mulBarrett(LOAD(a + i), LOAD(b + i), vq, ratioHi, ratioLo);
+        STORE(acc + i, addMod(LOAD(acc + i), p, vq));
+    }
+    g_simdScalar.mulAddMod(a + i, b + i, acc + i, n - i, q);
+}
+
+static void avx512MulScalarMod(const uint64_t* a, uint64_t w, uint64_t wShoup, uint64_t* out, uint32_t n,
+                               const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    const __m512i vw = _mm512_set1_epi64((long long)w);
+    const __m512i vwShoup = _mm512_set1_epi64((long long)wShoup);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        STORE(out + i, mulShoup(LOAD(a + i), vw, vwShoup, vq));
+    }
+    g_simdScalar.mulScalarMod(a + i, w, wShoup, out + i, n - i, q);
+}
+
+static void avx512ReduceSigned(const int64_t* a, uint64_t* out, uint32_t n, const ModulusWords& q) {
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    const __m512i ratioHi = _mm512_set1_epi64((long long)q.ratioHi);
+    const __m512i zero = _mm512_setzero_si512();
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = LOAD(a + i);
+        __mmask8 negative = _mm512_cmplt_epi64_mask(x, zero);
+        __m512i magnitude = _mm512_abs_epi64(x);
+
+        __m512i r = _mm512_sub_epi64(magnitude, _mm512_mullo_epi64(mulHi(magnitude, ratioHi), vq));
+        r = reduceOnce(r, vq);
+        __m512i negated = _mm512_maskz_sub_epi64(_mm512_cmpneq_epi64_mask(r, zero), vq, r);
+        STORE(out + i, _mm512_mask_blend_epi64(negative, r, negated));
+    }
+    g_simdScalar.reduceSigned(a + i, out + i, n - i, q);
+}
+
+static void avx512NttForwardStage(uint64_t* a, uint32_t m, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                  const ModulusWords& q) {
+    if (t < 8) {
+        g_simdAvx2.nttForwardStage(a, m, t, w, wShoup, q);
+        return;
+    }
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    for (uint32_t i = 0; i < m; i++) {
+        const __m512i wi = _mm512_set1_epi64((long long)w[m + i]);
+        const __m512i wiShoup = _mm512_set1_epi64((long long)wShoup[m + i]);
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j += 8) {
+            __m512i u = LOAD(x + j);
+            __m512i v = mulShoup(LOAD(y + j), wi, wiShoup, vq);
+            STORE(x + j, addMod(u, v, vq));
+            STORE(y + j, subMod(u, v, vq));
+        }
+    }
+}
+
+static void avx512NttInverseStage(uint64_t* a, uint32_t h, uint32_t t, const uint64_t* w, const uint64_t* wShoup,
+                                  const ModulusWords& q) {
+    if (t < 8) {
+        g_simdAvx2.nttInverseStage(a, h, t, w, wShoup, q);
+        return;
+    }
+    const __m512i vq = _mm512_set1_epi64((long long)q.value);
+    for (uint32_t i = 0; i < h; i++) {
+        const __m512i wi = _mm512_set1_epi64((long long)w[h + i]);
+        const __m512i wiShoup = _mm512_set1_epi64((long long)wShoup[h + i]);
+        uint64_t* x = a + 2 * i * t;
+        uint64_t* y = x + t;
+        for (uint32_t j = 0; j < t; j += 8) {
+            __m512i u = LOAD(x + j);
+            __m512i v = LOAD(y + j);
+            STORE(x + j, addMod(u, v, vq));
+            STORE(y + j, mulShoup(subMod(u, v, vq), wi, wiShoup, vq));
+        }
+    }
+}
+
+// Four interleaved complex values per register. There is no addsub at this
+// width, so the even (real) lanes add the negated product, which IEEE
+// defines to be the same as subtracting it.
+static inline __m512d complexMul(__m512d v, __m512d w) {
+    const __m512d evenSign = _mm512_set_pd(0.0, -0.0, 0.0, -0.0, 0.0, -0.0, 0.0, -0.0);
+    __m512d wReal = _mm512_movedup_pd(w);
+    __m512d wImag = _mm512_permute_pd(w, 0xFF);
+    __m512d swapped = _mm512_permute_pd(v, 0x55);
+    __m512d cross = _mm512_xor_pd(_mm512_mul_pd(swapped, wImag), evenSign);
+    return _mm512_add_pd(_mm512_mul_pd(v, wReal), cross);
+}
+
+static void avx512FftForwardStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    if (lenh < 4) {
+        g_simdAvx2.fftForwardStage(vals, slots, lenh, w);
+        return;
+    }
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        double* x = (double*)(vals + i);
+        double* y = (double*)(vals + i + lenh);
+        for (uint32_t j = 0; j < lenh; j += 4) {
+            __m512d u = _mm512_loadu_pd(x + 2 * j);
+            __m512d t = complexMul(_mm512_loadu_pd(y + 2 * j), _mm512_loadu_pd((const double*)(w + j)));
+            _mm512_storeu_pd(x + 2 * j, _mm512_add_pd(u, t));
+            _mm512_storeu_pd(y + 2 * j, _mm512_sub_pd(u, t));
+        }
+    }
+}
+
+static void avx512FftInverseStage(complex_t* vals, uint32_t slots, uint32_t lenh, const complex_t* w) {
+    if (lenh < 4) {
+        g_simdAvx2.fftInverseStage(vals, slots, lenh, w);
+        return;
+    }
+    for (uint32_t i = 0; i < slots; i += 2 * lenh) {
+        double* x = (double*)(vals + i);
+        double* y = (double*)(vals + i + lenh);
+        for (uint32_t j = 0; j < lenh; j += 4) {
+            __m512d u = _mm512_loadu_pd(x + 2 * j);
+            __m512d v = _mm512_loadu_pd(y + 2 * j);
+            _mm512_storeu_pd(x + 2 * j, _mm512_add_pd(u, v));
+            _mm512_storeu_pd(y + 2 * j, complexMul(_mm512_sub_pd(u, v), _mm512_loadu_pd((const double*)(w + j))));
+        }
+    }
+}
+
+static bool avx512SlotsToCoeffs(const complex_t* vals, uint32_t count, double scale, double bound,
+                                int64_t* real, int64_t* imag) {
+    const __m512d vscale = _mm512_set1_pd(scale);
+    const __m512d vbound = _mm512_set1_pd(bound);
+    const __m512d signMask = _mm512_set1_pd(-0.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512i split = _mm512_set_epi64(7, 5, 3, 1, 6, 4, 2, 0);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        // round(): truncate, then step away from zero if the fraction is >= 1/2
+        __m512d x = _mm512_mul_pd(_mm512_loadu_pd((const double*)(vals + i)), vscale);
+        __m512d t = _mm512_roundscale_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __mmask8 away = _mm512_cmp_pd_mask(_mm512_abs_pd(_mm512_sub_pd(x, t)), half, _CMP_GE_OQ);
+        t = _mm512_mask_add_pd(t, away, t, _mm512_or_pd(_mm512_and_pd(signMask, x), one));
+        if (_mm512_cmp_pd_mask(_mm512_abs_pd(t), vbound, _CMP_LT_OQ) != 0xFF) return false;
+
+        // (r0, i0, ..., r3, i3) -> (r0, ..., r3 | i0, ..., i3)
+        __m512i words = _mm512_permutexvar_epi64(split, _mm512_cvttpd_epi64(t));
+        _mm256_storeu_si256((__m256i*)(real + i), _mm512_castsi512_si256(words));
+        _mm256_storeu_si256((__m256i*)(imag + i), _mm512_extracti64x4_epi64(words, 1));
+    }
+    return g_simdScalar.slotsToCoeffs(vals + i, count - i, scale, bound, real + i, imag + i);
+}
+
+static void avx512CoeffsToSlots(const int64_t* real, const int64_t* imag, uint32_t count, double scale,
+                                complex_t* vals) {
+    const __m512d vscale = _mm512_set1_pd(scale);
+    const __m512i low = _mm512_set_epi64(11, 3, 10, 2, 9, 1, 8, 0);
+    const __m512i high = _mm512_set_epi64(15, 7, 14, 6, 13, 5, 12, 4);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m512d re = _mm512_div_pd(_mm512_cvtepi64_pd(LOAD(real + i)), vscale);
+        __m512d im = _mm512_div_pd(_mm512_cvtepi64_pd(LOAD(imag + i)), vscale);
+        _mm512_storeu_pd((double*)(vals + i), _mm512_permutex2var_pd(re, low, im));
+        _mm512_storeu_pd((double*)(vals + i + 4), _mm512_permutex2var_pd(re, high, im));
+    }
+    g_simdScalar.coeffsToSlots(real + i, imag + i, count - i, scale, vals + i);
+}
+
+const SimdKernels g_simdAvx512 = {
+    "avx512",
+    avx512AddMod, avx512SubMod, avx512MulMod, avx512MulAddMod, avx512MulScalarMod, avx512ReduceSigned,
+    avx512NttForwardStage, avx512NttInverseStage,
+    avx512FftForwardStage, avx512FftInverseStage,
+    avx512SlotsToCoeffs, avx512CoeffsToSlots
+};
@@ -0,0 +1,99 @@
+#include "TableCache.h"
+#include "MemStats.h"
+#include "Platform.h"
+#include <stddef.h>
+
+// Singly linked; a handful of entries per ring dimension in use
+typedef struct TableEntry {
+    uint32_t n;
+    uint64_t q;                 // 0 for an FFT plan
+    uint32_t refs;
+    NTTTables* ntt;
+    FFTPlan* plan;
+    struct TableEntry* next;
+} TableEntry;
+
+static TableEntry* g_tables = NULL;
+static sgx_thread_mutex_t g_tablesLock = SGX_THREAD_MUTEX_INITIALIZER;
+
+// Callers hold g_tablesLock
+static TableEntry* findEntry(uint32_t n, uint64_t q) {
+    for (TableEntry* e = g_tables; e != NULL; e = e->next) {
+        if (e->n == n && e->q == q) return e;
+    }
+    return NULL;
+}
+
+static TableEntry* addEntry(uint32_t n, uint64_t q) {
+    TableEntry* e = new TableEntry;
+    if (e == NULL) return NULL;
+    e->n = n;
+    e->q = q;
+    e->refs = 0;
+    e->ntt = NULL;
+    e->plan = NULL;
+    bool ok;
+    if (q != 0) {
+        e->ntt = new NTTTables;
+        ok = (e->ntt != NULL) && e->ntt->init(n, Modulus(q));
+    } else {
+        e->plan = new FFTPlan;
+        ok = (e->plan != NULL) && e->plan->init(n);
+    }
+    if (!ok) {
+        delete e->ntt;
+        delete e->plan;
+        delete e;
+        return NULL;
+    }
+    memStatsHeapAlloc(sizeof(TableEntry));
+    e->next = g_tables;
+    g_tables = e;
+    return e;
+}
+
+static TableEntry* acquire(uint32_t n, uint64_t q) {
+    sgx_thread_mutex_lock(&g_tablesLock);
+    TableEntry* e = findEntry(n, q);
+    if (e == NULL) e = addEntry(n, q);
+    if (e != NULL) e->refs++;
+    sgx_thread_mutex_unlock(&g_tablesLock);
+    return e;
+}
+
+static void release(const void* tables) {
+    if (tables == NULL) return;
+    sgx_thread_mutex_lock(&g_tablesLock);
+    for (TableEntry** link = &g_tables; *link != NULL; link = &(*link)->next) {
+        TableEntry* e = *link;
+        if ((const void*)e->ntt != tables && (const void*)e->plan != tables) continue;
+        if (--e->refs == 0) {
+            *link = e->next;
+            delete e->ntt;
+            delete e->plan;
+            delete e;
+            memStatsHeapFree(sizeof(TableEntry));
+        }
+        break;
+    }
+    sgx_thread_mutex_unlock(&g_tablesLock);
+}
+
+const NTTTables* acquireNttTables(uint32_t n, uint64_t q) {
+    if (q == 0) return NULL;
+    TableEntry* e = acquire(n, q);
+    return (e != NULL) ? e->ntt : NULL;
+}
+
+void releaseNttTables(const NTTTables* tables) {
+    release(tables);
+}
+
+const FFTPlan* acquireFftPlan(uint32_t n) {
+    TableEntry* e = acquire(n, 0);
+    return (e != NULL) ? e->plan : NULL;
+}
+
+void releaseFftPlan(const FFTPlan* plan) {
+    release(plan);
+}
@@ -0,0 +1,19 @@
+// TableCache.h - Transform tables shared by every context with the same ring dimension
+#ifndef _TABLE_CACHE_H_
+#define _TABLE_CACHE_H_
+
+#include "NTT.h"
+#include "FFT.h"
+#include <stdint.h>
+
+// NTT tables depend only on (N, q) and the FFT plan only on N, so contexts
+// with the same ring dimension (and, for the NTT, the same primes) use one
+// read-only copy. Entries are reference counted and freed with the last
+// context using them. acquire* returns NULL if the tables cannot be built.
+const NTTTables* acquireNttTables(uint32_t n, uint64_t q);
+void releaseNttTables(const NTTTables* tables);
+
+const FFTPlan* acquireFftPlan(uint32_t n);
+void releaseFftPlan(const FFTPlan* plan);
+
+#endif // _TABLE_CACHE_H_
@@ -0,0 +1,33 @@
+#include "Workspace.h"
+#include "MemStats.h"
+#include <stdlib.h>
+#include <string.h>
+
+Workspace::Workspace() : raw(NULL), base(NULL), capacity(0), used(0) {
+}
+
+Workspace::~Workspace() {
+    if (raw != NULL) {
+        // Scratch buffers held secret-dependent intermediates
+        memset(base, 0, capacity);
+        free(raw);
+        memStatsHeapFree(capacity + WORKSPACE_ALIGNMENT);
+    }
+}
+
+bool Workspace::init(size_t bytes) {
+    if (raw != NULL) return false;
+
+    capacity = (bytes + WORKSPACE_ALIGNMENT - 1) & ~(size_t)(WORKSPACE_ALIGNMENT - 1);
+    raw = (uint8_t*)malloc(capacity + WORKSPACE_ALIGNMENT);
+    if (raw == NULL) {
+        capacity = 0;
+        return false;
+    }
+
+    uintptr_t addr = (uintptr_t)raw;
+    base = (uint8_t*)((addr + WORKSPACE_ALIGNMENT - 1) & ~(uintptr_t)(WORKSPACE_ALIGNMENT - 1));
+    used = 0;
+    memStatsHeapAlloc(capacity + WORKSPACE_ALIGNMENT);
+    return true;
+}
@@ -0,0 +1,44 @@
+// Workspace.h - Preallocated scratch arena reused across CKKS operations
+#ifndef _WORKSPACE_H_
+#define _WORKSPACE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WORKSPACE_ALIGNMENT 64
+
+// Bump allocator over one aligned block sized at context creation. Callers
+// take buffers and hand them back with mark()/release(); nothing is zeroed,
+// so every buffer must be fully written before it is read.
+class Workspace {
+private:
+    uint8_t* raw;
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+
+    Workspace(const Workspace&);
+    Workspace& operator=(const Workspace&);
+
+public:
+    Workspace();
+    ~Workspace();
+
+    bool init(size_t bytes);
+    size_t size() const { return capacity; }
+
+    size_t mark() const { return used; }
+    void release(size_t position) { used = position; }
+
+    // Returns NULL if the arena is exhausted
+    template <typename T>
+    T* take(size_t count) {
+        size_t bytes = (count * sizeof(T) + WORKSPACE_ALIGNMENT - 1) & ~(size_t)(WORKSPACE_ALIGNMENT - 1);
+        if (base == NULL || bytes > capacity - used) return NULL;
+        T* p = (T*)(void*)(base + used);
+        used += bytes;
+        return p;
+    }
+};
+
+#endif // _WORKSPACE_H_
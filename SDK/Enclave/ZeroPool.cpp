@@ -0,0 +1,180 @@
+#include "ZeroPool.h"
+#include "MemStats.h"
+#include <string.h>
+#include <stdlib.h>
+
+enum {
+    ENTRY_FREE = 0,
+    ENTRY_FILLING,
+    ENTRY_READY,
+    ENTRY_TAKEN
+};
+
+ZeroPool::ZeroPool()
+    : block(NULL), state(NULL), depth(0), entryWords(0), ready(0), workers(0), stopping(false), releases(0),
+      hits(0), misses(0), refills(0) {
+    sgx_thread_mutex_init(&lock, NULL);
+    sgx_thread_cond_init(&changed, NULL);
+}
+
+ZeroPool::~ZeroPool() {
+    freeBlock();
+    sgx_thread_cond_destroy(&changed);
+    sgx_thread_mutex_destroy(&lock);
+}
+
+void ZeroPool::freeBlock() {
+    if (block != NULL) {
+        // Entries are masks for whatever gets added to them
+        const size_t bytes = (size_t)depth * entryWords * sizeof(uint64_t);
+        memset(block, 0, bytes);
+        free(block);
+        free(state);
+        memStatsHeapFree(bytes + depth);
+    }
+    block = NULL;
+    state = NULL;
+    depth = 0;
+    entryWords = 0;
+    ready = 0;
+}
+
+sgx_status_t ZeroPool::configure(uint32_t newDepth, size_t words) {
+    if (newDepth > ZERO_POOL_MAX_DEPTH || (newDepth > 0 && words == 0)) return SGX_ERROR_INVALID_PARAMETER;
+
+    sgx_thread_mutex_lock(&lock);
+    freeBlock();
+    sgx_status_t status = SGX_SUCCESS;
+    if (newDepth > 0) {
+        block = (uint64_t*)malloc((size_t)newDepth * words * sizeof(uint64_t));
+        state = (uint8_t*)calloc(newDepth, 1);
+        if (block == NULL || state == NULL) {
+            free(block);
+            free(state);
+            block = NULL;
+            state = NULL;
+            status = SGX_ERROR_OUT_OF_MEMORY;
+        } else {
+            depth = newDepth;
+            entryWords = words;
+            memStatsHeapAlloc((size_t)depth * entryWords * sizeof(uint64_t) + depth);
+        }
+    }
+    stopping = false;
+    sgx_thread_mutex_unlock(&lock);
+    return status;
+}
+
+void ZeroPool::clear() {
+    sgx_thread_mutex_lock(&lock);
+    for (uint32_t i = 0; i < depth; i++) {
+        if (state[i] == ENTRY_READY) state[i] = ENTRY_FREE;
+    }
+    ready = 0;
+    releases++;
+    sgx_thread_cond_broadcast(&changed);
+    sgx_thread_mutex_unlock(&lock);
+}
+
+bool ZeroPool::enter() {
+    sgx_thread_mutex_lock(&lock);
+    const bool ok = (depth > 0 && !stopping);
+    if (ok) workers++;
+    sgx_thread_mutex_unlock(&lock);
+    return ok;
+}
+
+void ZeroPool::leave() {
+    sgx_thread_mutex_lock(&lock);
+    workers--;
+    sgx_thread_cond_broadcast(&changed);
+    sgx_thread_mutex_unlock(&lock);
+}
+
+bool ZeroPool::claim(uint32_t* slot, uint64_t* epoch) {
+    sgx_thread_mutex_lock(&lock);
+    *epoch = releases;
+    bool found = false;
+    for (uint32_t i = 0; i < depth && !stopping; i++) {
+        if (state[i] == ENTRY_FREE) {
+            state[i] = ENTRY_FILLING;
+            *slot = i;
+            found = true;
+            break;
+        }
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return found;
+}
+
+void ZeroPool::filled(uint32_t slot, bool ok) {
+    sgx_thread_mutex_lock(&lock);
+    state[slot] = ok ? ENTRY_READY : ENTRY_FREE;
+    if (ok) {
+        ready++;
+        refills++;
+    }
+    sgx_thread_mutex_unlock(&lock);
+}
+
+bool ZeroPool::wait(uint64_t epoch) {
+    sgx_thread_mutex_lock(&lock);
+    while (!stopping && releases == epoch) sgx_thread_cond_wait(&changed, &lock);
+    const bool ok = !stopping;
+    sgx_thread_mutex_unlock(&lock);
+    return ok;
+}
+
+void ZeroPool::stop() {
+    sgx_thread_mutex_lock(&lock);
+    stopping = true;
+    sgx_thread_cond_broadcast(&changed);
+    while (workers > 0) sgx_thread_cond_wait(&changed, &lock);
+    sgx_thread_mutex_unlock(&lock);
+}
+
+const uint64_t* ZeroPool::take(uint32_t* slot) {
+    sgx_thread_mutex_lock(&lock);
+    const uint64_t* zero = NULL;
+    for (uint32_t i = 0; i < depth && ready > 0; i++) {
+        if (state[i] == ENTRY_READY) {
+            state[i] = ENTRY_TAKEN;
+            ready--;
+            *slot = i;
+            zero = entry(i);
+            break;
+        }
+    }
+    if (zero != NULL) {
+        hits++;
+    } else if (depth > 0) {
+        misses++;
+    }
+    sgx_thread_mutex_unlock(&lock);
+    return zero;
+}
+
+void ZeroPool::release(uint32_t slot) {
+    sgx_thread_mutex_lock(&lock);
+    state[slot] = ENTRY_FREE;
+    releases++;
+    sgx_thread_cond_signal(&changed);
+    sgx_thread_mutex_unlock(&lock);
+}
+
+void ZeroPool::getStats(uint64_t* outHits, uint64_t* outMisses, uint64_t* outRefills, uint32_t* outReady) {
+    sgx_thread_mutex_lock(&lock);
+    *outHits = hits;
+    *outMisses = misses;
+    *outRefills = refills;
+    *outReady = ready;
+    sgx_thread_mutex_unlock(&lock);
+}
+
+void ZeroPool::resetStats() {
+    sgx_thread_mutex_lock(&lock);
+    hits = 0;
+    misses = 0;
+    refills = 0;
+    sgx_thread_mutex_unlock(&lock);
+}
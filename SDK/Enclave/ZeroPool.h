@@ -0,0 +1,77 @@
+// ZeroPool.h - Precomputed public-key encryptions of zero for encrypt
+#ifndef _ZERO_POOL_H_
+#define _ZERO_POOL_H_
+
+#include "Platform.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Entries per pool; each holds c0 and c1 of one ciphertext (2 * L * N words)
+#define ZERO_POOL_MAX_DEPTH 1024
+
+// Everything in a public-key encryption except encoding the message and
+// adding it to c0 is independent of the message, so refill workers do it
+// ahead of time and encrypt consumes one entry per ciphertext. An entry is
+// handed out once and only becomes ready again after a worker has
+// overwritten it with fresh randomness.
+//
+// The pool only manages entries; the caller computes them. Entries are
+// read and written while the caller holds the context's read lock, and
+// configure() and clear() run under its write lock, so neither ever sees
+// an entry in use.
+class ZeroPool {
+private:
+    uint64_t* block;            // depth entries of entryWords
+    uint8_t* state;             // per entry: free, filling, ready or taken
+    uint32_t depth;
+    size_t entryWords;
+    uint32_t ready;
+    uint32_t workers;
+    bool stopping;
+    // Bumped whenever an entry becomes free, so a worker that found none
+    // does not miss the release that happens before it waits
+    uint64_t releases;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t refills;
+    sgx_thread_mutex_t lock;
+    sgx_thread_cond_t changed;
+
+    ZeroPool(const ZeroPool&);
+    ZeroPool& operator=(const ZeroPool&);
+
+    void freeBlock();
+
+public:
+    ZeroPool();
+    ~ZeroPool();
+
+    // Replaces the entries with `depth` empty ones of `words` each; 0
+    // disables the pool. Call stop() first so that no worker is inside.
+    sgx_status_t configure(uint32_t depth, size_t words);
+    // Forgets every ready entry, e.g. because the keys changed
+    void clear();
+
+    // Refill workers. enter() is false while the pool is disabled or
+    // stopping. claim() reserves a free entry to fill; when there is none
+    // it returns false and the caller waits with the `epoch` it got.
+    // wait() returns false once the pool is stopping.
+    bool enter();
+    void leave();
+    bool claim(uint32_t* slot, uint64_t* epoch);
+    uint64_t* entry(uint32_t slot) const { return block + (size_t)slot * entryWords; }
+    void filled(uint32_t slot, bool ok);
+    bool wait(uint64_t epoch);
+    // Makes workers leave and blocks until they have
+    void stop();
+
+    // encrypt: a ready entry (counted as a hit) or NULL (a miss). The
+    // entry must be given back with release() once it has been read.
+    const uint64_t* take(uint32_t* slot);
+    void release(uint32_t slot);
+
+    void getStats(uint64_t* hits, uint64_t* misses, uint64_t* refills, uint32_t* ready);
+    void resetStats();
+};
+
+#endif // _ZERO_POOL_H_
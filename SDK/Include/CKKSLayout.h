@@ -0,0 +1,76 @@
+// CKKSLayout.h - Ciphertext buffer layout shared by the App and the Enclave
+#ifndef _CKKS_LAYOUT_H_
+#define _CKKS_LAYOUT_H_
+
+#include <stdint.h>
+
+// Supported ring degrees N (powers of two); contexts size their keys,
+// tables and scratch to the N they are created with
+#define MIN_POLY_DEGREE 1024
+#define MAX_POLY_DEGREE 32768
+
+// Longest RNS modulus chain (q_0 plus the scaling primes)
+#define MAX_MODULI 8
+
+// Ciphertext buffers are int64 arrays: a header followed by the RNS limbs
+// of c0 and then of c1, each limb holding polyDegree residues:
+//   [header][c0 mod q_0]...[c0 mod q_{L-1}][c1 mod q_0]...[c1 mod q_{L-1}]
+typedef struct {
+    uint32_t numModuli;     // L, limbs per component (level + 1)
+    uint32_t flags;         // CKKS_CT_FLAG_* bits
+    double scale;           // scaling factor of the encoded message
+} CKKSCiphertextHeader;
+
+#define CKKS_CT_HEADER_WORDS (sizeof(CKKSCiphertextHeader) / sizeof(int64_t))
+
+// Number of int64 words of a ciphertext with numModuli limbs
+#define CKKS_CT_WORDS(polyDegree, numModuli) \
+    (CKKS_CT_HEADER_WORDS + 2 * (size_t)(polyDegree) * (size_t)(numModuli))
+
+// Secret-key ciphertexts replace the c1 limbs with the 32-byte seed they
+// are expanded from (limb by limb, directly in NTT form), halving the size:
+//   [header][c0 mod q_0]...[c0 mod q_{L-1}][seed]
+#define CKKS_CT_FLAG_SEEDED 0x1
+#define CKKS_CT_SEED_BYTES 32
+#define CKKS_CT_SEED_WORDS (CKKS_CT_SEED_BYTES / sizeof(int64_t))
+
+#define CKKS_CT_SEEDED_WORDS(polyDegree, numModuli) \
+    (CKKS_CT_HEADER_WORDS + (size_t)(polyDegree) * (size_t)(numModuli) + CKKS_CT_SEED_WORDS)
+
+// Key files are a header recording the parameters the key was generated
+// for, followed by the key's RNS limbs laid out as above (secret key: s;
+// public key: b, then a; relinearization key: for every digit j, b_j and
+// then a_j, each over q_0 ... q_{L-1} and the special prime P). Loading
+// rejects a file whose header does not match the context exactly.
+#define CKKS_KEY_MAGIC 0x594b4b43      // "CKKY"
+#define CKKS_KEY_VERSION 2
+
+#define CKKS_KEY_SECRET 1
+#define CKKS_KEY_PUBLIC 2
+#define CKKS_KEY_RELIN 3
+
+#define CKKS_REPR_COEFF 0              // coefficient form
+#define CKKS_REPR_NTT 1                // negacyclic NTT form, bit-reversed order
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t keyType;
+    uint32_t representation;
+    uint32_t polyDegree;
+    uint32_t numModuli;
+    uint64_t moduli[MAX_MODULI];
+    uint64_t specialModulus;           // P
+} CKKSKeyHeader;
+
+// Number of residue polynomials in a key
+#define CKKS_KEY_POLYS(keyType, numModuli) \
+    ((keyType) == CKKS_KEY_SECRET ? (size_t)(numModuli) : \
+     (keyType) == CKKS_KEY_PUBLIC ? 2 * (size_t)(numModuli) : \
+     2 * (size_t)(numModuli) * ((size_t)(numModuli) + 1))
+
+// Number of bytes of a key file
+#define CKKS_KEY_FILE_BYTES(keyType, polyDegree, numModuli) \
+    (sizeof(CKKSKeyHeader) + CKKS_KEY_POLYS(keyType, numModuli) * (size_t)(polyDegree) * sizeof(uint64_t))
+
+#endif // _CKKS_LAYOUT_H_
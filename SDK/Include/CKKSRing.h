@@ -0,0 +1,178 @@
+// CKKSRing.h - Asynchronous request ring shared by the App and the Enclave
+#ifndef _CKKS_RING_H_
+#define _CKKS_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// The host allocates one ring in untrusted memory and registers it with
+// ecall_register_ring. Enclave threads parked in ecall_ring_worker take
+// requests from the submission queue and post one completion per request.
+// Requests name the caller's buffers by address: the enclave reads the
+// input from them once and writes the result straight into them, so no
+// marshalling copies are made. The buffers must stay untouched until the
+// completion with the request's tag arrives.
+//
+//   op                    reads                            writes
+//   CKKS_RING_OP_ENCRYPT  msgReal, msgImag (msgLen each)   ciphertext (ctLen words)
+//   CKKS_RING_OP_DECRYPT  ciphertext (ctLen words)         msgReal, msgImag (msgLen each)
+#define CKKS_RING_OP_ENCRYPT 1
+#define CKKS_RING_OP_DECRYPT 2
+
+// Slots per queue; a power of two
+#define CKKS_RING_MAX_CAPACITY 4096
+
+typedef struct {
+    uint64_t tag;           // chosen by the host, echoed in the completion
+    uint32_t op;            // CKKS_RING_OP_*
+    uint32_t msgLen;
+    uint32_t ctLen;
+    uint32_t context;       // handle from ecall_init_ckks
+    uint64_t msgReal;       // addresses in the host process
+    uint64_t msgImag;
+    uint64_t ciphertext;
+} CKKSRingRequest;
+
+typedef struct {
+    uint64_t tag;
+    uint32_t status;        // sgx_status_t of the operation
+    uint32_t reserved;
+} CKKSRingCompletion;
+
+// Both queues are bounded multi-producer multi-consumer queues: a slot's
+// sequence says whose turn it is (Vyukov). For slot index i of position
+// pos, sequence == pos means free to fill and pos + 1 means filled.
+typedef struct {
+    uint64_t sequence;
+    CKKSRingRequest request;
+} CKKSRingRequestSlot;
+
+typedef struct {
+    uint64_t sequence;
+    CKKSRingCompletion completion;
+} CKKSRingCompletionSlot;
+
+// Each position counter sits on its own cache line. The request slots,
+// then the completion slots, follow the header.
+typedef struct {
+    uint64_t submitHead;            // next request position to fill (host)
+    uint8_t pad0[56];
+    uint64_t submitTail;            // next request position to take (enclave)
+    uint8_t pad1[56];
+    uint64_t completeHead;          // next completion position to fill (enclave)
+    uint8_t pad2[56];
+    uint64_t completeTail;          // next completion position to take (host)
+    uint8_t pad3[56];
+    uint32_t capacity;              // slots per queue
+    uint32_t stop;                  // set by the host; workers return once they see it
+    uint8_t pad4[56];
+} CKKSRingHeader;
+
+#define CKKS_RING_BYTES(capacity) \
+    (sizeof(CKKSRingHeader) + (size_t)(capacity) * (sizeof(CKKSRingRequestSlot) + sizeof(CKKSRingCompletionSlot)))
+
+static inline CKKSRingRequestSlot* ckksRingRequests(CKKSRingHeader* ring) {
+    return (CKKSRingRequestSlot*)(ring + 1);
+}
+
+static inline CKKSRingCompletionSlot* ckksRingCompletions(CKKSRingHeader* ring, uint32_t capacity) {
+    return (CKKSRingCompletionSlot*)(ckksRingRequests(ring) + capacity);
+}
+
+// Empty queues; the host calls this before registering the ring
+static inline void ckksRingInit(CKKSRingHeader* ring, uint32_t capacity) {
+    memset(ring, 0, CKKS_RING_BYTES(capacity));
+    ring->capacity = capacity;
+    CKKSRingRequestSlot* requests = ckksRingRequests(ring);
+    CKKSRingCompletionSlot* completions = ckksRingCompletions(ring, capacity);
+    for (uint32_t i = 0; i < capacity; i++) {
+        requests[i].sequence = i;
+        completions[i].sequence = i;
+    }
+}
+
+// Claims the slot at *head for filling; false when the queue is full.
+// `capacity` is the caller's own copy, so a corrupted header cannot move
+// an index out of the slots.
+static inline bool ckksRingClaim(uint64_t* head, const uint64_t* sequence0, size_t stride, uint32_t capacity,
+                                 uint64_t* position) {
+    uint64_t pos = __atomic_load_n(head, __ATOMIC_RELAXED);
+    for (;;) {
+        const uint64_t* sequence = (const uint64_t*)((const uint8_t*)sequence0 + (pos & (capacity - 1)) * stride);
+        int64_t diff = (int64_t)(__atomic_load_n(sequence, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *position = pos;
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Claims the filled slot at *tail for taking; false when the queue is empty
+static inline bool ckksRingTake(uint64_t* tail, const uint64_t* sequence0, size_t stride, uint32_t capacity,
+                                uint64_t* position) {
+    uint64_t pos = __atomic_load_n(tail, __ATOMIC_RELAXED);
+    for (;;) {
+        const uint64_t* sequence = (const uint64_t*)((const uint8_t*)sequence0 + (pos & (capacity - 1)) * stride);
+        int64_t diff = (int64_t)(__atomic_load_n(sequence, __ATOMIC_ACQUIRE) - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *position = pos;
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static inline bool ckksRingSubmit(CKKSRingHeader* ring, uint32_t capacity, const CKKSRingRequest* request) {
+    CKKSRingRequestSlot* slots = ckksRingRequests(ring);
+    uint64_t pos;
+    if (!ckksRingClaim(&ring->submitHead, &slots[0].sequence, sizeof(*slots), capacity, &pos)) return false;
+    CKKSRingRequestSlot* slot = &slots[pos & (capacity - 1)];
+    slot->request = *request;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Copies the request out of the ring, then frees its slot
+static inline bool ckksRingNextRequest(CKKSRingHeader* ring, uint32_t capacity, CKKSRingRequest* request) {
+    CKKSRingRequestSlot* slots = ckksRingRequests(ring);
+    uint64_t pos;
+    if (!ckksRingTake(&ring->submitTail, &slots[0].sequence, sizeof(*slots), capacity, &pos)) return false;
+    CKKSRingRequestSlot* slot = &slots[pos & (capacity - 1)];
+    *request = slot->request;
+    __atomic_store_n(&slot->sequence, pos + capacity, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool ckksRingComplete(CKKSRingHeader* ring, uint32_t capacity, const CKKSRingCompletion* completion) {
+    CKKSRingCompletionSlot* slots = ckksRingCompletions(ring, capacity);
+    uint64_t pos;
+    if (!ckksRingClaim(&ring->completeHead, &slots[0].sequence, sizeof(*slots), capacity, &pos)) return false;
+    CKKSRingCompletionSlot* slot = &slots[pos & (capacity - 1)];
+    slot->completion = *completion;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static inline bool ckksRingNextCompletion(CKKSRingHeader* ring, uint32_t capacity, CKKSRingCompletion* completion) {
+    CKKSRingCompletionSlot* slots = ckksRingCompletions(ring, capacity);
+    uint64_t pos;
+    if (!ckksRingTake(&ring->completeTail, &slots[0].sequence, sizeof(*slots), capacity, &pos)) return false;
+    CKKSRingCompletionSlot* slot = &slots[pos & (capacity - 1)];
+    *completion = slot->completion;
+    __atomic_store_n(&slot->sequence, pos + capacity, __ATOMIC_RELEASE);
+    return true;
+}
+
+#endif // _CKKS_RING_H_
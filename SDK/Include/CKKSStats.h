@@ -0,0 +1,19 @@
+// CKKSStats.h - Hot-path phases reported by ecall_get_stats
+#ifndef _CKKS_STATS_H_
+#define _CKKS_STATS_H_
+
+// Every instrumented call adds one call and its TSC cycles to its phase.
+// Phases do not nest: the sampler, transforms and products are timed in
+// their own leaves, and reductions at the call sites that convert between
+// representations.
+#define CKKS_PHASE_SAMPLE 0         // ternary, Gaussian and uniform sampling, seed expansion
+#define CKKS_PHASE_ENCODE 1         // slot FFT and rounding to coefficients
+#define CKKS_PHASE_TRANSFORM 2      // forward and inverse NTTs
+#define CKKS_PHASE_PRODUCT 3        // pointwise NTT-domain products
+#define CKKS_PHASE_REDUCE 4         // residue reductions, RNS lifts, rescale and mod-down
+#define CKKS_PHASE_DECODE 5         // coefficients back to slots
+#define CKKS_PHASE_COUNT 6
+
+#define CKKS_PHASE_NAMES { "sample", "encode", "transform", "product", "reduce", "decode" }
+
+#endif // _CKKS_STATS_H_
@@ -0,0 +1,184 @@
+// Bench.cpp - Microbenchmarks of the CKKS core built as a plain process
+// (ckks_native). Same sources and parameters as the enclave, so the gap to
+// `ckks_app` is the cost of running inside SGX.
+#include "CKKS.h"
+#include "Simd.h"
+#include "BenchUtil.h"
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+// Deterministic filler for the transform inputs
+uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+const char* const KERNELS[] = {"polyMul", "fft", "encode", "encrypt", "decrypt"};
+const int NUM_KERNELS = 5;
+
+int main(int argc, char* argv[]) {
+    // Positional arguments; --name=value flags may appear anywhere
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]).compare(0, 2, "--") != 0) args.push_back(argv[i]);
+    }
+
+    int iterations = (args.size() > 0) ? std::stoi(args[0]) : 1000;
+    int polyDegree = (args.size() > 1) ? std::stoi(args[1]) : 8192;
+    double scale = (args.size() > 2) ? std::stod(args[2]) : (1 << 30);
+    int depth = (args.size() > 3) ? std::stoi(args[3]) : 1;
+    int slots = std::stoi(get_option(argc, argv, "slots", std::to_string(polyDegree / 2)));
+    std::string kernel = get_option(argc, argv, "kernel", "all");
+    int warmup = std::stoi(get_option(argc, argv, "warmup", "10"));
+    // Per-operation latencies of the selected kernel go here, one per line
+    std::string samples_file = get_option(argc, argv, "samples", "");
+
+    bool known = (kernel == "all");
+    for (int k = 0; k < NUM_KERNELS; k++) known = known || (kernel == KERNELS[k]);
+    if (iterations < 1 || slots < 1 || depth < 0 || depth >= MAX_MODULI || warmup < 0 || !known ||
+        (!samples_file.empty() && kernel == "all")) {
+        std::cerr << "Usage: " << argv[0] << " [iterations] [polyDegree] [scale] [depth] [--slots=S]"
+                  << " [--kernel=all|polyMul|fft|encode|encrypt|decrypt] [--warmup=N]"
+                  << " [--samples=path (one kernel only)]" << std::endl;
+        return -1;
+    }
+
+    // Same context setup as ecall_init_ckks
+    uint32_t level = simdInit();
+    CKKSParams params;
+    params.polyDegree = (uint32_t)polyDegree;
+    params.scale = scale;
+    params.slots = (uint32_t)slots;
+    params.numModuli = (uint32_t)depth + 1;
+    if (!buildModulusChain(params.polyDegree, scale, (uint32_t)depth, params.moduli) ||
+        !findSpecialModulus(params.polyDegree, params.moduli, params.numModuli, &params.specialModulus)) {
+        std::cerr << "No modulus chain for these parameters" << std::endl;
+        return -1;
+    }
+    CKKS ckks(params);
+    if (!ckks.isValid() || ckks.keyGen() != SGX_SUCCESS) {
+        std::cerr << "Failed to initialize CKKS" << std::endl;
+        return -1;
+    }
+
+    // Transform tables for every limb of the chain; polyMul is one
+    // negacyclic product in RNS form, as encrypt computes it
+    const uint32_t n = params.polyDegree;
+    const uint32_t L = params.numModuli;
+    std::vector<NTTTables> tables(L);
+    std::vector<uint64_t> a((size_t)L * n), b((size_t)L * n), product((size_t)L * n);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (uint32_t j = 0; j < L; j++) {
+        Modulus q(params.moduli[j]);
+        if (!tables[j].init(n, q)) {
+            std::cerr << "Failed to build NTT tables" << std::endl;
+            return -1;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            a[(size_t)j * n + i] = q.reduce(next_random(&state));
+            b[(size_t)j * n + i] = q.reduce(next_random(&state));
+        }
+    }
+    std::vector<uint64_t> a_work(a.size()), b_work(b.size());
+
+    FFTPlan plan;
+    if (!plan.init(n)) {
+        std::cerr << "Failed to build the FFT plan" << std::endl;
+        return -1;
+    }
+    std::vector<complex_t> vals(slots);
+
+    std::vector<double> msg_real(slots), msg_imag(slots);
+    for (int i = 0; i < slots; i++) {
+        msg_real[i] = i * 1.1;
+        msg_imag[i] = i * 0.5;
+    }
+    std::vector<int64_t> polynomial(n);
+    std::vector<int64_t> ciphertext(CKKS_CT_WORDS(n, L));
+    std::vector<double> result_real(slots), result_imag(slots);
+    if (ckks.encrypt(msg_real.data(), msg_imag.data(), slots, ciphertext.data(),
+                     (uint32_t)ciphertext.size()) != SGX_SUCCESS) {
+        std::cerr << "Encryption failed" << std::endl;
+        return -1;
+    }
+
+    std::cout << "Native CKKS core: N=" << n << ", " << L << " moduli, " << slots << " slots, "
+              << simdKernels().name << " kernels (level " << level << ")" << std::endl;
+    std::cout << "kernel,iterations,mean_us,p50_us,p99_us" << std::endl;
+
+    for (int k = 0; k < NUM_KERNELS; k++) {
+        const std::string name = KERNELS[k];
+        if (kernel != "all" && kernel != name) continue;
+
+        std::vector<double> samples;
+        bool ok = true;
+        for (int i = 0; i < warmup + iterations && ok; i++) {
+            // Transforms work in place; restore their inputs untimed
+            if (name == "polyMul") {
+                a_work = a;
+                b_work = b;
+            } else if (name == "fft") {
+                for (int s = 0; s < slots; s++) {
+                    vals[s].real = msg_real[s];
+                    vals[s].imag = msg_imag[s];
+                }
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (name == "polyMul") {
+                for (uint32_t j = 0; j < L; j++) {
+                    const size_t offset = (size_t)j * n;
+                    tables[j].forward(&a_work[offset]);
+                    tables[j].forward(&b_work[offset]);
+                    tables[j].multiplyPointwise(&a_work[offset], &b_work[offset], &product[offset]);
+                    tables[j].inverse(&product[offset]);
+                }
+            } else if (name == "fft") {
+                // Interpolate and evaluate, i.e. the transforms of encode and decode
+                plan.embedInverse(vals.data(), slots);
+                plan.embed(vals.data(), slots);
+            } else if (name == "encode") {
+                ok = ckks.encodeMessage(msg_real.data(), msg_imag.data(), slots, polynomial.data(),
+                                        n) == SGX_SUCCESS;
+            } else if (name == "encrypt") {
+                ok = ckks.encrypt(msg_real.data(), msg_imag.data(), slots, ciphertext.data(),
+                                  (uint32_t)ciphertext.size()) == SGX_SUCCESS;
+            } else {
+                ok = ckks.decrypt(ciphertext.data(), (uint32_t)ciphertext.size(), result_real.data(),
+                                  result_imag.data(), slots) == SGX_SUCCESS;
+            }
+            if (i >= warmup) samples.push_back(elapsed_ms(start));
+        }
+        if (!ok) {
+            std::cerr << name << " failed" << std::endl;
+            return -1;
+        }
+
+        if (!samples_file.empty() && !write_samples(samples_file, samples)) {
+            std::cerr << "Failed to write " << samples_file << std::endl;
+            return -1;
+        }
+        LatencySummary summary = summarize(samples);
+        std::cout << name << "," << iterations << "," << summary.mean * 1000.0 << "," << summary.p50 * 1000.0
+                  << "," << summary.p99 * 1000.0 << std::endl;
+    }
+
+    // Round trip of the last ciphertext, as a sanity check on the numbers
+    double max_error = 0.0;
+    if (ckks.decrypt(ciphertext.data(), (uint32_t)ciphertext.size(), result_real.data(), result_imag.data(),
+                     slots) == SGX_SUCCESS) {
+        for (int i = 0; i < slots; i++) {
+            max_error = std::max(max_error, std::fabs(result_real[i] - msg_real[i]));
+            max_error = std::max(max_error, std::fabs(result_imag[i] - msg_imag[i]));
+        }
+    }
+    std::cout << "Round-trip error: " << max_error << std::endl;
+    return 0;
+}
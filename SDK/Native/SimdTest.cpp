@@ -0,0 +1,237 @@
+// SimdTest.cpp - Checks that every kernel set the CPU can run matches the
+// scalar kernels bit for bit (simd_test, `make test`). Unlike the
+// self-check simdInit() runs on fixed inputs, this covers random inputs at
+// every supported N and modulus widths from 30 to 61 bits, reports each
+// kernel that differs and exits non-zero.
+#include "CKKSLayout.h"
+#include "Simd.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+
+static const uint32_t MODULUS_BITS[] = {30, 31, 36, 40, 45, 50, 55, 59, 60, 61};
+static const int NUM_MODULUS_BITS = sizeof(MODULUS_BITS) / sizeof(MODULUS_BITS[0]);
+
+// xorshift64*; the seed is printed so a failure can be replayed with --seed
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static double random_unit(uint64_t* state) {
+    return (double)(int64_t)next_random(state) * (1.0 / 9223372036854775808.0);
+}
+
+// An odd modulus of exactly `bits` bits; the kernels need no primality
+static Modulus random_modulus(uint32_t bits, uint64_t* state) {
+    uint64_t q = next_random(state) >> (64 - bits);
+    return Modulus(q | (1ULL << (bits - 1)) | 1);
+}
+
+class Checker {
+private:
+    const SimdKernels& kernels;
+    std::string context;
+    int failures;
+
+public:
+    explicit Checker(const SimdKernels& k) : kernels(k), failures(0) {}
+
+    void at(const std::string& where) { context = where; }
+    int failed() const { return failures; }
+
+    void fail(const std::string& message) {
+        std::cerr << "FAIL " << kernels.name << " " << message << " " << context << std::endl;
+        failures++;
+    }
+
+    // Reports the first differing word of `what`
+    bool same(const char* what, const void* expected, const void* actual, size_t words) {
+        const uint64_t* e = (const uint64_t*)expected;
+        const uint64_t* a = (const uint64_t*)actual;
+        for (size_t i = 0; i < words; i++) {
+            if (e[i] != a[i]) {
+                std::cerr << "FAIL " << kernels.name << " " << what << " " << context << ": word " << i
+                          << " is " << a[i] << ", scalar gives " << e[i] << std::endl;
+                failures++;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static void check_modular(const SimdKernels& k, Checker& check, uint32_t n, const Modulus& mod, uint64_t* state) {
+    const ModulusWords q = mod.words();
+    const SimdKernels& s = g_simdScalar;
+    std::vector<uint64_t> a(n), b(n), w(n), wShoup(n), expected(n), actual(n);
+    std::vector<int64_t> signedWords(n);
+    for (uint32_t i = 0; i < n; i++) {
+        a[i] = mod.reduce(next_random(state));
+        b[i] = mod.reduce(next_random(state));
+        w[i] = mod.reduce(next_random(state));
+        wShoup[i] = mod.shoup(w[i]);
+        signedWords[i] = (int64_t)next_random(state);
+    }
+    a[0] = 0;
+    b[1] = mod.value() - 1;
+    a[2] = b[2] = mod.value() - 1;
+    signedWords[0] = INT64_MIN;
+    signedWords[1] = INT64_MAX;
+    signedWords[2] = -(int64_t)mod.value();
+
+    // Element-wise kernels at full length and with a tail shorter than a vector
+    const uint32_t lengths[2] = {n, n - 3};
+    for (int l = 0; l < 2; l++) {
+        const uint32_t len = lengths[l];
+        s.addMod(a.data(), b.data(), expected.data(), len, q);
+        k.addMod(a.data(), b.data(), actual.data(), len, q);
+        check.same("addMod", expected.data(), actual.data(), len);
+
+        s.subMod(a.data(), b.data(), expected.data(), len, q);
+        k.subMod(a.data(), b.data(), actual.data(), len, q);
+        check.same("subMod", expected.data(), actual.data(), len);
+
+        s.mulMod(a.data(), b.data(), expected.data(), len, q);
+        k.mulMod(a.data(), b.data(), actual.data(), len, q);
+        check.same("mulMod", expected.data(), actual.data(), len);
+
+        expected = w;
+        actual = w;
+        s.mulAddMod(a.data(), b.data(), expected.data(), len, q);
+        k.mulAddMod(a.data(), b.data(), actual.data(), len, q);
+        check.same("mulAddMod", expected.data(), actual.data(), len);
+
+        s.mulScalarMod((const uint64_t*)signedWords.data(), w[5], wShoup[5], expected.data(), len, q);
+        k.mulScalarMod((const uint64_t*)signedWords.data(), w[5], wShoup[5], actual.data(), len, q);
+        check.same("mulScalarMod", expected.data(), actual.data(), len);
+
+        s.reduceSigned(signedWords.data(), expected.data(), len, q);
+        k.reduceSigned(signedWords.data(), actual.data(), len, q);
+        check.same("reduceSigned", expected.data(), actual.data(), len);
+    }
+
+    // Every layer of a forward and an inverse transform of size n; the
+    // twiddles need not be roots of unity for the arithmetic to be compared
+    expected = a;
+    actual = a;
+    for (uint32_t m = 1, t = n / 2; m < n; m <<= 1, t >>= 1) {
+        s.nttForwardStage(expected.data(), m, t, w.data(), wShoup.data(), q);
+        k.nttForwardStage(actual.data(), m, t, w.data(), wShoup.data(), q);
+    }
+    check.same("nttForwardStage", expected.data(), actual.data(), n);
+
+    actual = expected;
+    for (uint32_t h = n / 2, t = 1; h >= 1; h >>= 1, t <<= 1) {
+        s.nttInverseStage(expected.data(), h, t, w.data(), wShoup.data(), q);
+        k.nttInverseStage(actual.data(), h, t, w.data(), wShoup.data(), q);
+    }
+    check.same("nttInverseStage", expected.data(), actual.data(), n);
+}
+
+static void check_slots(const SimdKernels& k, Checker& check, uint32_t n, uint64_t* state) {
+    const SimdKernels& s = g_simdScalar;
+    const uint32_t slots = n / 2;
+    const double scale = (double)(1ULL << (20 + next_random(state) % 21));
+    std::vector<complex_t> vals(slots), w(slots), expected(slots), actual(slots);
+    std::vector<int64_t> real[2], imag[2];
+    for (int v = 0; v < 2; v++) {
+        real[v].resize(slots);
+        imag[v].resize(slots);
+    }
+    for (uint32_t i = 0; i < slots; i++) {
+        vals[i].real = random_unit(state) * 1000.0;
+        vals[i].imag = random_unit(state) * 1000.0;
+        w[i].real = random_unit(state);
+        w[i].imag = random_unit(state);
+    }
+
+    expected = vals;
+    actual = vals;
+    for (uint32_t lenh = 1; lenh < slots; lenh <<= 1) {
+        s.fftForwardStage(expected.data(), slots, lenh, w.data());
+        k.fftForwardStage(actual.data(), slots, lenh, w.data());
+    }
+    check.same("fftForwardStage", expected.data(), actual.data(), 2 * (size_t)slots);
+
+    actual = expected;
+    for (uint32_t lenh = slots / 2; lenh >= 1; lenh >>= 1) {
+        s.fftInverseStage(expected.data(), slots, lenh, w.data());
+        k.fftInverseStage(actual.data(), slots, lenh, w.data());
+    }
+    check.same("fftInverseStage", expected.data(), actual.data(), 2 * (size_t)slots);
+
+    // Rounding ties, then a value past the bound
+    vals[0].real = 2.5 / scale;
+    vals[0].imag = -2.5 / scale;
+    vals[1].real = -0.5 / scale;
+    const double bound = 4611686018427387904.0;
+    const uint32_t count = slots - 1;
+    bool okExpected = s.slotsToCoeffs(vals.data(), count, scale, bound, real[0].data(), imag[0].data());
+    bool okActual = k.slotsToCoeffs(vals.data(), count, scale, bound, real[1].data(), imag[1].data());
+    if (okExpected != okActual) check.fail("slotsToCoeffs accepts what the scalar kernel rejects or vice versa");
+    check.same("slotsToCoeffs real", real[0].data(), real[1].data(), count);
+    check.same("slotsToCoeffs imag", imag[0].data(), imag[1].data(), count);
+
+    vals[count / 2].imag = 2.0 * bound / scale;
+    okExpected = s.slotsToCoeffs(vals.data(), count, scale, bound, real[0].data(), imag[0].data());
+    okActual = k.slotsToCoeffs(vals.data(), count, scale, bound, real[1].data(), imag[1].data());
+    if (okExpected || okActual) check.fail("slotsToCoeffs accepted a value past the bound");
+
+    // Full-range words, so the int64 -> double conversion must round alike
+    for (uint32_t i = 0; i < slots; i++) {
+        real[0][i] = (int64_t)next_random(state);
+        imag[0][i] = (int64_t)next_random(state) >> (i % 64);
+    }
+    real[0][0] = INT64_MIN;
+    imag[0][0] = INT64_MAX;
+    s.coeffsToSlots(real[0].data(), imag[0].data(), count, scale, expected.data());
+    k.coeffsToSlots(real[0].data(), imag[0].data(), count, scale, actual.data());
+    check.same("coeffsToSlots", expected.data(), actual.data(), 2 * (size_t)count);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t seed = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--seed=", 7) == 0) seed = strtoull(argv[i] + 7, NULL, 0);
+    }
+    if (seed == 0) seed = 1;
+    std::cout << "simd_test --seed=" << seed << std::endl;
+
+    // Only the kernel sets this CPU executes; the others are reported as skipped
+    std::vector<const SimdKernels*> sets;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        sets.push_back(&g_simdAvx2);
+    } else {
+        std::cout << "skip " << g_simdAvx2.name << ": not supported by this CPU" << std::endl;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+        sets.push_back(&g_simdAvx512);
+    } else {
+        std::cout << "skip " << g_simdAvx512.name << ": not supported by this CPU" << std::endl;
+    }
+
+    int failures = 0;
+    for (size_t v = 0; v < sets.size(); v++) {
+        uint64_t state = seed;
+        Checker check(*sets[v]);
+        for (uint32_t n = MIN_POLY_DEGREE; n <= MAX_POLY_DEGREE; n <<= 1) {
+            for (int b = 0; b < NUM_MODULUS_BITS; b++) {
+                Modulus mod = random_modulus(MODULUS_BITS[b], &state);
+                check.at("N=" + std::to_string(n) + " q=" + std::to_string(mod.value()));
+                check_modular(*sets[v], check, n, mod, &state);
+            }
+            check.at("N=" + std::to_string(n));
+            check_slots(*sets[v], check, n, &state);
+        }
+        std::cout << (check.failed() ? "FAIL " : "ok ") << sets[v]->name << std::endl;
+        failures += check.failed();
+    }
+    return (failures == 0) ? 0 : 1;
+}
@@ -1,12 +1,14 @@
 #!/bin/bash
 
 # Combined SGX CKKS Benchmark Script
-# Usage: ./benchmark.sh [iterations]
+# Usage: ./benchmark.sh [iterations] [batch]
 
 ITERATIONS=${1:-100}
+BATCH=${2:-1}
 WARMUP_ITERATIONS=5
 POLY_DEGREE=8192
 SCALE=1073741824  # 2^30
+DEPTH=1
 
 # Colors for output
 GREEN='\033[0;32m'
@@ -19,29 +21,32 @@ echo "Iterations: $ITERATIONS"
 echo "Warm-up Iterations: $WARMUP_ITERATIONS"
 echo "Polynomial Degree: $POLY_DEGREE"
 echo "Scale: $SCALE"
+echo "Depth: $DEPTH"
+echo "Batch Size: $BATCH"
 echo "=============================================="
 
 # Generate keys if they don't exist
 if [ ! -f "ckks_secret_key.bin" ] || [ ! -f "ckks_public_key.bin" ]; then
     echo -e "${BLUE}Generating keys...${NC}"
-    ./ckks_app genkeys 1 $POLY_DEGREE $SCALE
+    ./ckks_app genkeys 1 $POLY_DEGREE $SCALE $DEPTH
 fi
 
 # Function to run benchmark for a specific mode
 run_benchmark() {
     local mode=$1
+    local batch_flag="--batch=$BATCH"
 
     # Warm-up runs
     echo -e "${BLUE}Running warm-up for $mode...${NC}"
     for ((i=1; i<=$WARMUP_ITERATIONS; i++))
     do
-        ./ckks_app $mode 1 $POLY_DEGREE $SCALE > /dev/null 2>&1
+        ./ckks_app $mode 1 $POLY_DEGREE $SCALE $DEPTH $batch_flag > /dev/null 2>&1
     done
 
     # Actual benchmark with external timing
     echo -e "${BLUE}Running $mode benchmark...${NC}"
     start_time=$(date +%s.%N)
-    ./ckks_app $mode $ITERATIONS $POLY_DEGREE $SCALE > /dev/null 2>&1
+    ./ckks_app $mode $ITERATIONS $POLY_DEGREE $SCALE $DEPTH $batch_flag > /dev/null 2>&1
     end_time=$(date +%s.%N)
     duration=$(echo "$end_time - $start_time" | bc -l)
 
@@ -61,4 +66,46 @@ run_benchmark "encrypt"
 # Run decryption benchmark
 run_benchmark "decrypt"
 
+# Batched variants amortize the enclave transition over BATCH operations
+if [ "$BATCH" -gt 1 ]; then
+    run_benchmark "encrypt-batch"
+    run_benchmark "decrypt-batch"
+fi
+
+# Enclave workers fed through the request ring, without one ecall per operation
+echo -e "${BLUE}Running async benchmark...${NC}"
+for op in encrypt decrypt
+do
+    echo -e "${GREEN}$(./ckks_app async $ITERATIONS $POLY_DEGREE $SCALE $DEPTH --threads=2 --inflight=16 --op=$op | tail -n 1)${NC}"
+done
+echo "--------------------------------------------"
+
+# Same operations against one long-lived server, which pays enclave
+# creation, context setup and key loading once instead of per launch
+run_server_benchmark() {
+    local socket="ckks_bench.sock"
+    if [ ! -x ./ckks_client ]; then
+        return
+    fi
+
+    echo -e "${BLUE}Starting ckks_app server...${NC}"
+    ./ckks_app serve 0 $POLY_DEGREE $SCALE $DEPTH --socket=$socket > /dev/null 2>&1 &
+    local server_pid=$!
+    for ((i=1; i<=50; i++)); do
+        [ -S "$socket" ] && break
+        sleep 0.1
+    done
+
+    for op in encrypt decrypt; do
+        echo -e "${BLUE}Running server $op benchmark...${NC}"
+        ./ckks_client $ITERATIONS --socket=$socket --op=$op --warmup=$WARMUP_ITERATIONS
+        echo "--------------------------------------------"
+    done
+
+    kill $server_pid
+    wait $server_pid 2>/dev/null
+}
+
+run_server_benchmark
+
 echo -e "${YELLOW}Benchmark complete!${NC}"
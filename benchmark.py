@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+"""Runs the SDK enclave, its native build (ckks_native) and the OpenFHE
+(Gramine) benchmarks over one parameter grid, records every operation's
+latency and writes JSON/CSV.
+
+Each target is run once per grid point and operation with --samples, so the
+benchmark binary itself reports one latency per operation; the first
+--warmup samples of every run are dropped. With --baseline, the run is
+compared against an earlier JSON result and the script exits with status 1
+if any shared configuration got slower than --tolerance allows.
+
+  ./benchmark.py --targets=sdk,gramine-sgx --poly-degrees=8192,16384 \\
+      --iterations=200 --json=run.json --csv=run.csv --baseline=base.json
+
+Grid axes: ring dimension, scale (log2), depth, slots (0 = N/2), batch
+size and threads. Batches apply to the SDK only (ops per ecall). Threads
+are concurrent callers: ecalls for the SDK (throughput mode, which needs
+ENCLAVE_TCS >= threads) and workers sharing one context for OpenFHE, each
+running --omp-threads OpenMP threads per operation.
+"""
+
+import argparse
+import csv
+import itertools
+import json
+import math
+import os
+import platform
+import subprocess
+import sys
+import time
+
+ROOT = os.path.dirname(os.path.abspath(__file__))
+SDK_DIR = os.path.join(ROOT, "SDK")
+GRAMINE_DIR = os.path.join(ROOT, "Gramine")
+
+# A result is identified by its target, operation and grid point
+KEY_FIELDS = ["target", "op", "poly_degree", "scale_bits", "depth", "slots", "batch", "threads"]
+STAT_FIELDS = ["count", "mean_ms", "stdev_ms", "min_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms", "ops_per_sec"]
+
+
+def int_list(text):
+    return [int(x) for x in text.split(",") if x]
+
+
+def percentile(sorted_samples, p):
+    """Nearest-rank percentile, as ckks_app and ckks_client report it."""
+    if not sorted_samples:
+        return 0.0
+    rank = int(math.ceil(p * len(sorted_samples)))
+    return sorted_samples[max(rank, 1) - 1]
+
+
+def summarize(samples, concurrency):
+    ordered = sorted(samples)
+    count = len(ordered)
+    mean = sum(ordered) / count
+    variance = sum((x - mean) ** 2 for x in ordered) / (count - 1) if count > 1 else 0.0
+    return {
+        "count": count,
+        "mean_ms": mean,
+        "stdev_ms": math.sqrt(variance),
+        "min_ms": ordered[0],
+        "p50_ms": percentile(ordered, 0.50),
+        "p90_ms": percentile(ordered, 0.90),
+        "p99_ms": percentile(ordered, 0.99),
+        "max_ms": ordered[-1],
+        # Concurrent callers overlap, so throughput scales with them
+        "ops_per_sec": concurrency * 1000.0 / mean if mean > 0 else 0.0,
+    }
+
+
+def read_samples(path):
+    with open(path) as f:
+        return [float(line) for line in f if line.strip()]
+
+
+class Target:
+    """A benchmark binary and how to run it for one grid point."""
+
+    def __init__(self, name, directory):
+        self.name = name
+        self.directory = directory
+
+    def available(self):
+        raise NotImplementedError
+
+    def supports(self, point):
+        return True
+
+    def prepare(self, point):
+        """Called before the runs of a grid point, e.g. to generate keys."""
+
+    def command(self, op, point, runs, samples):
+        raise NotImplementedError
+
+    def concurrency(self, point):
+        return 1
+
+
+class SdkTarget(Target):
+    """ckks_app with the signed enclave."""
+
+    def __init__(self):
+        Target.__init__(self, "sdk", SDK_DIR)
+        self.keyed = None
+
+    def available(self):
+        return os.path.exists(os.path.join(SDK_DIR, "ckks_app")) and \
+            os.path.exists(os.path.join(SDK_DIR, "enclave.signed.so"))
+
+    def supports(self, point):
+        # Batched ecalls and concurrent callers are separate modes
+        return point["batch"] == 1 or point["threads"] == 1
+
+    def params(self, point):
+        return [str(point["poly_degree"]), str(2 ** point["scale_bits"]), str(point["depth"]),
+                "--slots=%d" % point["slots"]]
+
+    def prepare(self, point):
+        # Keys depend on the ring and the modulus chain, not on the slots
+        keyed = (point["poly_degree"], point["scale_bits"], point["depth"])
+        if self.keyed != keyed:
+            run(["./ckks_app", "genkeys", "1"] + self.params(point), SDK_DIR)
+            self.keyed = keyed
+
+    def command(self, op, point, runs, samples):
+        args = self.params(point) + ["--samples=" + samples]
+        if point["threads"] > 1:
+            return ["./ckks_app", "throughput", str(runs)] + args + \
+                ["--threads=%d" % point["threads"], "--op=" + op]
+        if point["batch"] > 1:
+            return ["./ckks_app", op + "-batch", str(runs)] + args + ["--batch=%d" % point["batch"]]
+        return ["./ckks_app", op, str(runs)] + args
+
+    def concurrency(self, point):
+        return point["threads"]
+
+
+class NativeTarget(Target):
+    """ckks_native: the enclave's CKKS core as a plain process, i.e. the SDK
+    numbers without SGX."""
+
+    def __init__(self):
+        Target.__init__(self, "native", SDK_DIR)
+
+    def available(self):
+        return os.path.exists(os.path.join(SDK_DIR, "ckks_native"))
+
+    def supports(self, point):
+        return point["batch"] == 1 and point["threads"] == 1
+
+    def command(self, op, point, runs, samples):
+        # The driver drops its own warm-up samples
+        return ["./ckks_native", str(runs), str(point["poly_degree"]), str(2 ** point["scale_bits"]),
+                str(point["depth"]), "--slots=%d" % point["slots"], "--kernel=" + op, "--warmup=0",
+                "--samples=" + samples]
+
+
+class OpenFheTarget(Target):
+    """The OpenFHE encrypt/decrypt benchmarks, natively or under Gramine."""
+
+    def __init__(self, name, loader):
+        Target.__init__(self, name, GRAMINE_DIR)
+        self.loader = loader
+        self.keys = "keys" if loader else "keys-native"
+
+    def available(self):
+        if not os.path.exists(os.path.join(GRAMINE_DIR, "encrypt_benchmark")):
+            return False
+        if self.loader == "gramine-sgx":
+            return os.path.exists(os.path.join(GRAMINE_DIR, "encrypt_benchmark.manifest.sgx"))
+        if self.loader == "gramine-direct":
+            return os.path.exists(os.path.join(GRAMINE_DIR, "encrypt_benchmark.manifest"))
+        return True
+
+    def supports(self, point):
+        return point["batch"] == 1
+
+    def prepare(self, point):
+        os.makedirs(os.path.join(GRAMINE_DIR, self.keys), exist_ok=True)
+
+    def command(self, op, point, runs, samples):
+        # Relative, so the paths resolve to the /samples and /keys mounts
+        # inside Gramine; the keys are generated once per parameter set.
+        # Native runs use keys-native: their plain files and the sealed ones
+        # under the encrypted /keys mount cannot be read by the other side.
+        binary = "%s_benchmark" % op
+        prefix = [self.loader, binary] if self.loader else ["./" + binary]
+        args = [str(runs), str(point["poly_degree"]), str(point["scale_bits"]), str(point["depth"]),
+                "--slots=%d" % point["slots"], "--threads=%d" % point["omp_threads"],
+                "--samples=" + os.path.relpath(samples, GRAMINE_DIR), "--keys=" + self.keys]
+        if point["threads"] > 1:
+            args.append("--workers=%d" % point["threads"])
+        return prefix + args
+
+    def concurrency(self, point):
+        return point["threads"]
+
+
+TARGETS = {
+    "sdk": SdkTarget,
+    "native": NativeTarget,
+    "openfhe": lambda: OpenFheTarget("openfhe", None),
+    "gramine-direct": lambda: OpenFheTarget("gramine-direct", "gramine-direct"),
+    "gramine-sgx": lambda: OpenFheTarget("gramine-sgx", "gramine-sgx"),
+}
+
+
+def run(command, directory):
+    result = subprocess.run(command, cwd=directory, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        raise RuntimeError("%s failed in %s:\n%s" % (" ".join(command), directory, result.stdout))
+    return result.stdout
+
+
+def grid(args):
+    axes = itertools.product(args.poly_degrees, args.scale_bits, args.depths, args.slots, args.batches,
+                             args.threads)
+    for poly_degree, scale_bits, depth, slots, batch, threads in axes:
+        yield {
+            "poly_degree": poly_degree,
+            "scale_bits": scale_bits,
+            "depth": depth,
+            "slots": slots if slots > 0 else poly_degree // 2,
+            "batch": batch,
+            "threads": threads,
+            "omp_threads": args.omp_threads,
+        }
+
+
+def run_grid(args):
+    results = []
+    for name in args.targets:
+        target = TARGETS[name]()
+        if not target.available():
+            print("skipping %s: not built" % name, file=sys.stderr)
+            continue
+        samples_dir = os.path.join(target.directory, "samples")
+        os.makedirs(samples_dir, exist_ok=True)
+
+        for point in grid(args):
+            if not target.supports(point):
+                continue
+            target.prepare(point)
+            for op in args.ops:
+                samples_file = os.path.join(samples_dir, "%s_%s.txt" % (name, op))
+                command = target.command(op, point, args.warmup + args.iterations, samples_file)
+                started = time.time()
+                run(command, target.directory)
+                samples = read_samples(samples_file)[args.warmup:]
+                os.remove(samples_file)
+                if not samples:
+                    raise RuntimeError("%s wrote no samples" % " ".join(command))
+
+                result = {"target": name, "op": op}
+                result.update(point)
+                result.update(summarize(samples, target.concurrency(point)))
+                result["wall_seconds"] = time.time() - started
+                result["samples_ms"] = samples
+                results.append(result)
+                print("%-14s %-7s N=%-5d 2^%d depth=%d slots=%d batch=%d threads=%d: "
+                      "p50 %.3f ms, p99 %.3f ms, %.1f ops/s"
+                      % (name, op, point["poly_degree"], point["scale_bits"], point["depth"], point["slots"],
+                         point["batch"], point["threads"], result["p50_ms"], result["p99_ms"],
+                         result["ops_per_sec"]), file=sys.stderr)
+    return results
+
+
+def write_json(path, args, results):
+    document = {
+        "meta": {
+            "time": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+            "host": platform.node(),
+            "platform": platform.platform(),
+            "iterations": args.iterations,
+            "warmup": args.warmup,
+        },
+        "results": results,
+    }
+    with open(path, "w") as f:
+        json.dump(document, f, indent=1)
+
+
+def write_csv(path, results):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=KEY_FIELDS + STAT_FIELDS, extrasaction="ignore")
+        writer.writeheader()
+        for result in results:
+            writer.writerow(result)
+
+
+def compare(results, baseline_path, metric, tolerance):
+    """Prints every configuration present in both runs; returns the number
+    whose metric grew by more than the tolerance."""
+    with open(baseline_path) as f:
+        baseline = {tuple(r[k] for k in KEY_FIELDS): r for r in json.load(f)["results"]}
+
+    regressions = 0
+    print("target,op,poly_degree,scale_bits,depth,slots,batch,threads,baseline_%s,%s,change,verdict"
+          % (metric, metric))
+    for result in results:
+        key = tuple(result[k] for k in KEY_FIELDS)
+        if key not in baseline:
+            continue
+        before, after = baseline[key][metric], result[metric]
+        change = (after - before) / before if before > 0 else 0.0
+        # Throughput regresses when it drops, latency when it rises
+        worse = -change if metric == "ops_per_sec" else change
+        verdict = "regression" if worse > tolerance else ("improvement" if worse < -tolerance else "same")
+        regressions += (verdict == "regression")
+        print(",".join(str(x) for x in key) + ",%.4f,%.4f,%+.1f%%,%s" % (before, after, 100 * change, verdict))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--targets", default="sdk,gramine-sgx",
+                        help="comma-separated: " + ", ".join(sorted(TARGETS)) + " (default: %(default)s)")
+    parser.add_argument("--ops", default="encrypt,decrypt")
+    parser.add_argument("--poly-degrees", type=int_list, default=[8192])
+    parser.add_argument("--scale-bits", type=int_list, default=[30])
+    parser.add_argument("--depths", type=int_list, default=[1])
+    parser.add_argument("--slots", type=int_list, default=[0], help="0 packs N/2 slots")
+    parser.add_argument("--batches", type=int_list, default=[1])
+    parser.add_argument("--threads", type=int_list, default=[1])
+    parser.add_argument("--omp-threads", type=int, default=1,
+                        help="OpenMP threads per OpenFHE operation, 0 for OpenMP's default (default: %(default)s)")
+    parser.add_argument("--iterations", type=int, default=100)
+    parser.add_argument("--warmup", type=int, default=5, help="leading samples dropped per run")
+    parser.add_argument("--json", help="write results with all samples")
+    parser.add_argument("--csv", help="write one summary row per result")
+    parser.add_argument("--baseline", help="JSON from an earlier run to compare against")
+    parser.add_argument("--metric", default="p50_ms", choices=STAT_FIELDS[1:])
+    parser.add_argument("--tolerance", type=float, default=0.10, help="relative change that counts (default 0.10)")
+    args = parser.parse_args()
+
+    args.targets = [t for t in args.targets.split(",") if t]
+    args.ops = [o for o in args.ops.split(",") if o]
+    for name in args.targets:
+        if name not in TARGETS:
+            parser.error("unknown target " + name)
+    if args.iterations < 1 or args.warmup < 0:
+        parser.error("need at least one iteration")
+
+    try:
+        results = run_grid(args)
+    except RuntimeError as error:
+        print(error, file=sys.stderr)
+        return 2
+
+    if args.json:
+        write_json(args.json, args, results)
+    if args.csv:
+        write_csv(args.csv, results)
+    if not args.json and not args.csv:
+        write_csv("/dev/stdout", results)
+    if args.baseline:
+        regressions = compare(results, args.baseline, args.metric, args.tolerance)
+        if regressions:
+            print("%d configuration(s) regressed by more than %.0f%%" % (regressions, 100 * args.tolerance),
+                  file=sys.stderr)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())